@@ -0,0 +1,164 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define ARENA_ALIGNMENT 16
+#define ARENA_DEFAULT_BLOCK (64 * 1024)
+#define ARENA_POOL_SIZE 8
+
+struct ArenaBlock {
+    ArenaBlock* next;
+    size_t size;          // usable bytes after the header
+    size_t used;
+};
+
+// header rounded up so block data starts aligned
+#define BLOCK_HEADER ((sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+static unsigned char* BlockData(ArenaBlock* block) {
+    return (unsigned char*)block + BLOCK_HEADER;
+}
+
+// arenas are created on the loader thread and destroyed on the game thread
+static Arena* pool[ARENA_POOL_SIZE];
+static int poolCount = 0;
+static pthread_mutex_t poolLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void FreeBlocks(ArenaBlock* block) {
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
+Arena* CreateArena(size_t blockSize) {
+    if (blockSize == 0)
+        blockSize = ARENA_DEFAULT_BLOCK;
+    Arena* arena = NULL;
+    pthread_mutex_lock(&poolLock);
+    if (poolCount > 0)
+        arena = pool[--poolCount];
+    pthread_mutex_unlock(&poolLock);
+    if (!arena) {
+        arena = (Arena*)calloc(1, sizeof(Arena));
+        if (!arena) return NULL;
+    }
+    arena->blockSize = blockSize;
+    return arena;
+}
+
+void ArenaReset(Arena* arena) {
+    // every block goes to the spare list, oversized one-off blocks are freed
+    ArenaBlock* block = arena->blocks;
+    while (block) {
+        ArenaBlock* next = block->next;
+        if (block->size > arena->blockSize && block->size > ARENA_DEFAULT_BLOCK) {
+            free(block);
+        } else {
+            block->used = 0;
+            block->next = arena->spare;
+            arena->spare = block;
+        }
+        block = next;
+    }
+    arena->blocks = NULL;
+    arena->last = NULL;
+    arena->lastSize = 0;
+}
+
+void DestroyArena(Arena* arena) {
+    if (!arena) return;
+    ArenaReset(arena);
+    pthread_mutex_lock(&poolLock);
+    if (poolCount < ARENA_POOL_SIZE) {
+        pool[poolCount++] = arena;
+        arena = NULL;
+    }
+    pthread_mutex_unlock(&poolLock);
+    if (arena) {
+        FreeBlocks(arena->spare);
+        free(arena);
+    }
+}
+
+static ArenaBlock* NewBlock(Arena* arena, size_t size) {
+    // reuse a spare block when one is big enough
+    ArenaBlock** link = &arena->spare;
+    while (*link) {
+        if ((*link)->size >= size) {
+            ArenaBlock* block = *link;
+            *link = block->next;
+            return block;
+        }
+        link = &(*link)->next;
+    }
+    size_t capacity = size > arena->blockSize ? size : arena->blockSize;
+    ArenaBlock* block = (ArenaBlock*)malloc(BLOCK_HEADER + capacity);
+    if (!block) return NULL;
+    block->size = capacity;
+    block->used = 0;
+    return block;
+}
+
+void* ArenaAlloc(Arena* arena, size_t size) {
+    size_t rounded = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (rounded == 0) rounded = ARENA_ALIGNMENT;
+    ArenaBlock* block = arena->blocks;
+    if (!block || block->size - block->used < rounded) {
+        block = NewBlock(arena, rounded);
+        if (!block) return NULL;
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+    void* p = BlockData(block) + block->used;
+    block->used += rounded;
+    arena->last = p;
+    arena->lastSize = rounded;
+    return p;
+}
+
+void* ArenaAllocZero(Arena* arena, size_t size) {
+    void* p = ArenaAlloc(arena, size);
+    if (p)
+        memset(p, 0, size);
+    return p;
+}
+
+void* ArenaRealloc(Arena* arena, void* old, size_t oldSize, size_t newSize) {
+    if (!old)
+        return ArenaAlloc(arena, newSize);
+    if (newSize <= oldSize)
+        return old;
+    ArenaBlock* block = arena->blocks;
+    size_t rounded = (newSize + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (old == arena->last && rounded <= arena->lastSize)
+        return old;
+    if (old == arena->last && block &&
+        block->size - (block->used - arena->lastSize) >= rounded) {
+        block->used += rounded - arena->lastSize;
+        arena->lastSize = rounded;
+        return old;
+    }
+    void* p = ArenaAlloc(arena, newSize);
+    if (p)
+        memcpy(p, old, oldSize);
+    return p;
+}
+
+char* ArenaStrdup(Arena* arena, const char* s) {
+    if (!s) return NULL;
+    size_t length = strlen(s) + 1;
+    char* copy = (char*)ArenaAlloc(arena, length);
+    if (copy)
+        memcpy(copy, s, length);
+    return copy;
+}
+
+size_t ArenaBytes(const Arena* arena) {
+    size_t bytes = 0;
+    for (const ArenaBlock* block = arena->blocks; block; block = block->next)
+        bytes += BLOCK_HEADER + block->size;
+    return bytes;
+}
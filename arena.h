@@ -0,0 +1,52 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bump allocator for data that lives exactly as long as a map or tileset.
+// Allocations are never freed one by one, the whole arena goes at once.
+// Destroyed arenas keep their blocks in a small pool so the next map load
+// reuses the same memory instead of going back to malloc.
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct Arena {
+    ArenaBlock* blocks;   // block being filled first
+    ArenaBlock* spare;    // emptied blocks waiting for reuse
+    size_t blockSize;
+    void* last;           // most recent allocation, can grow in place
+    size_t lastSize;
+} Arena;
+
+// takes an arena from the pool (or makes one), blockSize 0 for the default
+Arena* CreateArena(size_t blockSize);
+
+// empties the arena and returns it to the pool, NULL is fine
+void DestroyArena(Arena* arena);
+
+// 16 byte aligned, never NULL unless malloc fails
+void* ArenaAlloc(Arena* arena, size_t size);
+
+// same, zero filled
+void* ArenaAllocZero(Arena* arena, size_t size);
+
+// grows the most recent allocation in place when there is room, else copies
+void* ArenaRealloc(Arena* arena, void* old, size_t oldSize, size_t newSize);
+
+char* ArenaStrdup(Arena* arena, const char* s);
+
+// bytes of the blocks holding allocations, spare blocks not included
+size_t ArenaBytes(const Arena* arena);
+
+// forgets every allocation but keeps the blocks
+void ArenaReset(Arena* arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
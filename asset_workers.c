@@ -0,0 +1,229 @@
+#include "asset_workers.h"
+#include "constants.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct AssetTaskNode {
+    AssetTask task;
+    void* arg;
+    AssetJob* job;
+    struct AssetTaskNode* next;
+} AssetTaskNode;
+
+struct AssetJob {
+    int pending;               // queued or running tasks, guarded by queueLock
+};
+
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t taskQueued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t taskDone = PTHREAD_COND_INITIALIZER;
+static AssetTaskNode* queueHead = NULL;
+static AssetTaskNode* queueTail = NULL;
+static pthread_t workers[MAX_ASSET_WORKERS];
+static int workerCount = 0;
+static int quit = 0;
+
+// caller holds queueLock, job NULL takes any task
+static AssetTaskNode* PopTask(AssetJob* job) {
+    AssetTaskNode** link = &queueHead;
+    AssetTaskNode* previous = NULL;
+    while (*link && job && (*link)->job != job) {
+        previous = *link;
+        link = &(*link)->next;
+    }
+    AssetTaskNode* node = *link;
+    if (!node) return NULL;
+    *link = node->next;
+    if (queueTail == node)
+        queueTail = previous;
+    return node;
+}
+
+// caller holds queueLock, it is released while the task runs
+static void RunTask(AssetTaskNode* node) {
+    pthread_mutex_unlock(&queueLock);
+    node->task(node->arg);
+    pthread_mutex_lock(&queueLock);
+    if (--node->job->pending == 0)
+        pthread_cond_broadcast(&taskDone);
+    free(node);
+}
+
+static void* WorkerThread(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&queueLock);
+    for (;;) {
+        while (!quit && !queueHead)
+            pthread_cond_wait(&taskQueued, &queueLock);
+        if (quit) break;
+        RunTask(PopTask(NULL));
+    }
+    pthread_mutex_unlock(&queueLock);
+    return NULL;
+}
+
+void StartAssetWorkers(int count) {
+    if (workerCount > 0) return;
+    if (count <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        count = cores > 1 ? (int)cores - 1 : 1;
+    }
+    if (count > MAX_ASSET_WORKERS)
+        count = MAX_ASSET_WORKERS;
+    quit = 0;
+    for (int i = 0; i < count; i++) {
+        if (pthread_create(&workers[workerCount], NULL, WorkerThread, NULL) != 0) {
+            TraceLog(LOG_WARNING, "Started only %d of %d asset workers", workerCount, count);
+            break;
+        }
+        workerCount++;
+    }
+    TraceLog(LOG_INFO, "Asset workers: %d", workerCount);
+}
+
+void StopAssetWorkers(void) {
+    pthread_mutex_lock(&queueLock);
+    quit = 1;
+    pthread_cond_broadcast(&taskQueued);
+    pthread_mutex_unlock(&queueLock);
+    for (int i = 0; i < workerCount; i++)
+        pthread_join(workers[i], NULL);
+    workerCount = 0;
+}
+
+int GetAssetWorkerCount(void) {
+    return workerCount;
+}
+
+AssetJob* BeginAssetJob(void) {
+    return (AssetJob*)calloc(1, sizeof(AssetJob));
+}
+
+void QueueAssetTask(AssetJob* job, AssetTask task, void* arg) {
+    AssetTaskNode* node = (AssetTaskNode*)malloc(sizeof(AssetTaskNode));
+    if (!job || !node) {
+        // nowhere to queue it, run it right away
+        free(node);
+        task(arg);
+        return;
+    }
+    node->task = task;
+    node->arg = arg;
+    node->job = job;
+    node->next = NULL;
+    pthread_mutex_lock(&queueLock);
+    if (queueTail)
+        queueTail->next = node;
+    else
+        queueHead = node;
+    queueTail = node;
+    job->pending++;
+    pthread_cond_signal(&taskQueued);
+    pthread_mutex_unlock(&queueLock);
+}
+
+void FinishAssetJob(AssetJob* job) {
+    if (!job) return;
+    pthread_mutex_lock(&queueLock);
+    while (job->pending > 0) {
+        // help with our own tasks instead of just waiting for them
+        AssetTaskNode* node = PopTask(job);
+        if (node)
+            RunTask(node);
+        else
+            pthread_cond_wait(&taskDone, &queueLock);
+    }
+    pthread_mutex_unlock(&queueLock);
+    free(job);
+}
+
+typedef struct {
+    const char* path;
+    Image* out;
+} ImageDecode;
+
+static void DecodeImageTask(void* arg) {
+    ImageDecode* decode = (ImageDecode*)arg;
+    *decode->out = LoadImage(decode->path);
+    free(decode);
+}
+
+void QueueImageDecode(AssetJob* job, const char* path, Image* out) {
+    ImageDecode* decode = (ImageDecode*)malloc(sizeof(ImageDecode));
+    if (!decode) {
+        *out = LoadImage(path);
+        return;
+    }
+    decode->path = path;
+    decode->out = out;
+    QueueAssetTask(job, DecodeImageTask, decode);
+}
+
+typedef struct TextureRequest {
+    char* path;
+    Image image;
+    Texture2D* out;
+    TextureLoaded loaded;
+    void* user;
+    struct TextureRequest* next;
+} TextureRequest;
+
+struct TextureBatch {
+    AssetJob* job;
+    TextureRequest* first;
+    TextureRequest* last;
+};
+
+TextureBatch* BeginTextureBatch(void) {
+    TextureBatch* batch = (TextureBatch*)calloc(1, sizeof(TextureBatch));
+    if (batch)
+        batch->job = BeginAssetJob();
+    return batch;
+}
+
+void QueueTexture(TextureBatch* batch, const char* path, Texture2D* out,
+                  TextureLoaded loaded, void* user) {
+    TextureRequest* request = batch ? (TextureRequest*)calloc(1, sizeof(TextureRequest)) : NULL;
+    if (request)
+        request->path = strdup(path);
+    if (!request || !request->path) {
+        free(request);
+        *out = LoadTexture(path);
+        if (loaded) loaded(user);
+        return;
+    }
+    request->out = out;
+    request->loaded = loaded;
+    request->user = user;
+    if (batch->last)
+        batch->last->next = request;
+    else
+        batch->first = request;
+    batch->last = request;
+    QueueImageDecode(batch->job, request->path, &request->image);
+}
+
+void FinishTextureBatch(TextureBatch* batch) {
+    if (!batch) return;
+    FinishAssetJob(batch->job);
+    // every image is decoded, upload them back to back in queue order
+    TextureRequest* request = batch->first;
+    while (request) {
+        TextureRequest* next = request->next;
+        *request->out = (Texture2D){0};
+        if (request->image.data) {
+            *request->out = LoadTextureFromImage(request->image);
+            UnloadImage(request->image);
+        } else {
+            TraceLog(LOG_ERROR, "Failed to load texture: %s", request->path);
+        }
+        if (request->loaded)
+            request->loaded(request->user);
+        free(request->path);
+        free(request);
+        request = next;
+    }
+    free(batch);
+}
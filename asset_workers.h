@@ -0,0 +1,47 @@
+#ifndef ASSET_WORKERS_H
+#define ASSET_WORKERS_H
+
+#include "raylib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A pool of worker threads for the CPU side of loading: tileset parsing and
+// PNG decoding. Work is queued into an AssetJob and FinishAssetJob waits for
+// it, running the job's own tasks on the waiting thread as well, so it also
+// works (just serially) when no workers were started, as in mapc.
+// Nothing queued here may touch GL.
+
+typedef struct AssetJob AssetJob;
+typedef void (*AssetTask)(void* arg);
+
+// count 0 starts one worker per core besides the game thread
+void StartAssetWorkers(int count);
+void StopAssetWorkers(void);
+int GetAssetWorkerCount(void);
+
+AssetJob* BeginAssetJob(void);
+void QueueAssetTask(AssetJob* job, AssetTask task, void* arg);
+// waits for every task of the job, then frees it
+void FinishAssetJob(AssetJob* job);
+
+// *out = LoadImage(path) on a worker, path must live until the job finishes
+void QueueImageDecode(AssetJob* job, const char* path, Image* out);
+
+// Textures for the game thread: images decode on the workers and are all
+// uploaded by FinishTextureBatch, which must run on the GL thread
+typedef struct TextureBatch TextureBatch;
+typedef void (*TextureLoaded)(void* user);
+
+TextureBatch* BeginTextureBatch(void);
+// loaded(user) runs after *out is uploaded, for things sized by the texture
+void QueueTexture(TextureBatch* batch, const char* path, Texture2D* out,
+                  TextureLoaded loaded, void* user);
+void FinishTextureBatch(TextureBatch* batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,302 @@
+// Offline texture atlas packer: trims the PNGs in the given directories and
+// packs them onto a few atlas pages, plus the text file LoadTextureAtlas reads.
+//
+// usage: atlaspack <out.txt> <dir>...
+//        pages are written next to out.txt as <out>0.png, <out>1.png ...
+#include "texture_atlas.h"
+#include "constants.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char* path;
+    Image image;             // R8G8B8A8
+    int trimX, trimY;        // kept part of the image
+    int width, height;
+    int page, x, y;          // where it was packed, page -1 when it was not
+} PackedImage;
+
+static int EndsWith(const char* s, const char* suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+static int CompareNames(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// the .png paths in dir, sorted so the output does not depend on readdir
+static int ListImages(const char* dir, char*** out) {
+    DIR* d = opendir(dir);
+    if (!d) {
+        fprintf(stderr, "%s: cannot open directory\n", dir);
+        return 0;
+    }
+    char** paths = NULL;
+    int count = 0, capacity = 0;
+    struct dirent* e;
+    while ((e = readdir(d)) != NULL) {
+        if (e->d_name[0] == '.' || !EndsWith(e->d_name, ".png")) continue;
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            char** grown = (char**)realloc(paths, capacity * sizeof(char*));
+            if (!grown) break;
+            paths = grown;
+        }
+        size_t size = strlen(dir) + strlen(e->d_name) + 2;
+        paths[count] = (char*)malloc(size);
+        if (!paths[count]) break;
+        snprintf(paths[count], size, "%s/%s", dir, e->d_name);
+        count++;
+    }
+    closedir(d);
+    qsort(paths, count, sizeof(char*), CompareNames);
+    *out = paths;
+    return count;
+}
+
+// bounds of the pixels that are not fully transparent, grown to whole
+// BASE_TILE_SIZE cells so tile and frame grids stay intact. 0 when empty
+static int TrimImage(PackedImage* p) {
+    const unsigned char* pixels = (const unsigned char*)p->image.data;
+    int w = p->image.width, h = p->image.height;
+    int minX = w, minY = h, maxX = -1, maxY = -1;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (pixels[(y * w + x) * 4 + 3] == 0) continue;
+            if (x < minX) minX = x;
+            if (x > maxX) maxX = x;
+            if (y < minY) minY = y;
+            if (y > maxY) maxY = y;
+        }
+    }
+    if (maxX < 0) return 0;
+    int cell = BASE_TILE_SIZE;
+    p->trimX = minX / cell * cell;
+    p->trimY = minY / cell * cell;
+    int x1 = (maxX / cell + 1) * cell, y1 = (maxY / cell + 1) * cell;
+    p->width = (x1 < w ? x1 : w) - p->trimX;
+    p->height = (y1 < h ? y1 : h) - p->trimY;
+    return 1;
+}
+
+// tallest first, the skyline stays flatter that way
+static int CompareHeight(const void* a, const void* b) {
+    const PackedImage* pa = *(PackedImage* const*)a;
+    const PackedImage* pb = *(PackedImage* const*)b;
+    if (pa->height != pb->height) return pb->height - pa->height;
+    if (pa->width != pb->width) return pb->width - pa->width;
+    return strcmp(pa->path, pb->path);
+}
+
+typedef struct {
+    int x, y, width;
+} SkylineNode;
+
+// lowest spot (then leftmost) where a w x h rectangle fits under the page
+// height, -1 when there is none. *outY is its top
+static int FindSkylineSpot(const SkylineNode* nodes, int nodeCount, int w, int h, int* outY) {
+    int best = -1, bestY = 0;
+    for (int i = 0; i < nodeCount; i++) {
+        if (nodes[i].x + w > ATLAS_PAGE_SIZE) break;
+        // the rectangle rests on the highest node it spans
+        int y = 0, left = w;
+        for (int j = i; j < nodeCount && left > 0; j++) {
+            if (nodes[j].y > y) y = nodes[j].y;
+            left -= nodes[j].width;
+        }
+        if (y + h > ATLAS_PAGE_SIZE) continue;
+        if (best < 0 || y < bestY) {
+            best = i;
+            bestY = y;
+        }
+    }
+    *outY = bestY;
+    return best;
+}
+
+// raises the skyline over [x, x + w) to y, nodes has room for one more
+static int AddSkylineLevel(SkylineNode* nodes, int nodeCount, int index, int x, int y, int w) {
+    memmove(&nodes[index + 1], &nodes[index], (nodeCount - index) * sizeof(SkylineNode));
+    nodes[index] = (SkylineNode){ x, y, w };
+    nodeCount++;
+    // cut away what the new level covers
+    for (int i = index + 1; i < nodeCount; i++) {
+        int end = nodes[index].x + nodes[index].width;
+        if (nodes[i].x >= end) break;
+        int shrink = end - nodes[i].x;
+        nodes[i].x += shrink;
+        nodes[i].width -= shrink;
+        if (nodes[i].width > 0) break;
+        memmove(&nodes[i], &nodes[i + 1], (nodeCount - i - 1) * sizeof(SkylineNode));
+        nodeCount--;
+        i--;
+    }
+    // merge neighbours at the same height
+    for (int i = 0; i < nodeCount - 1; i++) {
+        if (nodes[i].y != nodes[i + 1].y) continue;
+        nodes[i].width += nodes[i + 1].width;
+        memmove(&nodes[i + 1], &nodes[i + 2], (nodeCount - i - 2) * sizeof(SkylineNode));
+        nodeCount--;
+        i--;
+    }
+    return nodeCount;
+}
+
+// Skyline bottom-left packing, each image reserves ATLAS_PADDING transparent
+// pixels right and below it. A new page starts when one does not fit
+static int PackImages(PackedImage** order, int count, int* pageWidth, int* pageHeight) {
+    SkylineNode* nodes = (SkylineNode*)malloc((count + 2) * sizeof(SkylineNode));
+    if (!nodes) return 0;
+    int page = 0, used = 0, nodeCount = 1;
+    nodes[0] = (SkylineNode){ 0, 0, ATLAS_PAGE_SIZE };
+    pageWidth[0] = pageHeight[0] = 0;
+    for (int i = 0; i < count; i++) {
+        PackedImage* p = order[i];
+        int w = p->width + ATLAS_PADDING, h = p->height + ATLAS_PADDING;
+        if (w > ATLAS_PAGE_SIZE) w = p->width;
+        if (h > ATLAS_PAGE_SIZE) h = p->height;
+        if (w > ATLAS_PAGE_SIZE || h > ATLAS_PAGE_SIZE) {
+            fprintf(stderr, "%s: %dx%d does not fit a page, left out\n", p->path, p->width, p->height);
+            continue;
+        }
+        int y;
+        int index = FindSkylineSpot(nodes, nodeCount, w, h, &y);
+        if (index < 0) {
+            page++;
+            pageWidth[page] = pageHeight[page] = 0;
+            nodeCount = 1;
+            nodes[0] = (SkylineNode){ 0, 0, ATLAS_PAGE_SIZE };
+            index = FindSkylineSpot(nodes, nodeCount, w, h, &y);
+        }
+        p->page = page;
+        p->x = nodes[index].x;
+        p->y = y;
+        nodeCount = AddSkylineLevel(nodes, nodeCount, index, p->x, y + h, w);
+        if (p->x + p->width > pageWidth[page]) pageWidth[page] = p->x + p->width;
+        if (p->y + p->height > pageHeight[page]) pageHeight[page] = p->y + p->height;
+        used = page + 1;
+    }
+    free(nodes);
+    return used;
+}
+
+static int WritePage(PackedImage* images, int count, int page, int width, int height, const char* path) {
+    unsigned char* pixels = (unsigned char*)calloc((size_t)width * height, 4);
+    if (!pixels) return 0;
+    for (int i = 0; i < count; i++) {
+        const PackedImage* p = &images[i];
+        if (p->page != page) continue;
+        const unsigned char* src = (const unsigned char*)p->image.data;
+        for (int row = 0; row < p->height; row++) {
+            memcpy(pixels + ((size_t)(p->y + row) * width + p->x) * 4,
+                   src + ((size_t)(p->trimY + row) * p->image.width + p->trimX) * 4,
+                   (size_t)p->width * 4);
+        }
+    }
+    Image image = { pixels, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    int ok = ExportImage(image, path);
+    free(pixels);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <out.txt> <dir>...\n", argv[0]);
+        return 1;
+    }
+    SetTraceLogLevel(LOG_WARNING);
+    const char* outPath = argv[1];
+
+    PackedImage* images = NULL;
+    int count = 0, capacity = 0;
+    for (int d = 2; d < argc; d++) {
+        char** paths = NULL;
+        int n = ListImages(argv[d], &paths);
+        for (int i = 0; i < n; i++) {
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 32;
+                PackedImage* grown = (PackedImage*)realloc(images, capacity * sizeof(PackedImage));
+                if (!grown) return 1;
+                images = grown;
+            }
+            PackedImage* p = &images[count];
+            memset(p, 0, sizeof(PackedImage));
+            p->path = paths[i];
+            p->page = -1;
+            p->image = LoadImage(paths[i]);
+            if (!p->image.data) {
+                fprintf(stderr, "%s: failed to load\n", paths[i]);
+                free(paths[i]);
+                continue;
+            }
+            ImageFormat(&p->image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+            if (!TrimImage(p)) {
+                // nothing visible, the game can load it on its own
+                UnloadImage(p->image);
+                free(paths[i]);
+                continue;
+            }
+            count++;
+        }
+        free(paths);
+    }
+
+    PackedImage** order = (PackedImage**)malloc((count > 0 ? count : 1) * sizeof(PackedImage*));
+    int* pageWidth = (int*)malloc((count + 1) * sizeof(int));
+    int* pageHeight = (int*)malloc((count + 1) * sizeof(int));
+    if (!order || !pageWidth || !pageHeight) return 1;
+    for (int i = 0; i < count; i++)
+        order[i] = &images[i];
+    qsort(order, count, sizeof(PackedImage*), CompareHeight);
+    int pages = PackImages(order, count, pageWidth, pageHeight);
+
+    // pages go next to out.txt: "dir/atlas.txt" -> "dir/atlas0.png"
+    char base[512];
+    snprintf(base, sizeof(base), "%s", outPath);
+    char* dot = strrchr(base, '.');
+    if (dot && !strchr(dot, '/')) *dot = '\0';
+
+    FILE* out = fopen(outPath, "w");
+    if (!out) {
+        fprintf(stderr, "%s: cannot write\n", outPath);
+        return 1;
+    }
+    fprintf(out, "# atlas %d\n", TEXTURE_ATLAS_VERSION);
+    int ok = 1;
+    long packedPixels = 0, sourcePixels = 0, pagePixels = 0;
+    for (int page = 0; page < pages && ok; page++) {
+        char pagePath[600];
+        snprintf(pagePath, sizeof(pagePath), "%s%d.png", base, page);
+        ok = WritePage(images, count, page, pageWidth[page], pageHeight[page], pagePath);
+        fprintf(out, "page %s\n", pagePath);
+        pagePixels += (long)pageWidth[page] * pageHeight[page];
+    }
+    for (int i = 0; i < count && ok; i++) {
+        const PackedImage* p = &images[i];
+        if (p->page < 0) continue;
+        fprintf(out, "image %d %d %d %d %d %d %d %d %d %s\n", p->page, p->x, p->y, p->width, p->height,
+                p->trimX, p->trimY, p->image.width, p->image.height, p->path);
+        packedPixels += (long)p->width * p->height;
+        sourcePixels += (long)p->image.width * p->image.height;
+    }
+    fclose(out);
+
+    for (int i = 0; i < count; i++) {
+        UnloadImage(images[i].image);
+        free(images[i].path);
+    }
+    free(images);
+    free(order);
+    free(pageWidth);
+    free(pageHeight);
+    if (!ok) {
+        fprintf(stderr, "%s: failed to write the atlas pages\n", outPath);
+        return 1;
+    }
+    printf("%s: %d images on %d pages, %ld of %ld pixels kept, pages %ld pixels\n",
+           outPath, count, pages, packedPixels, sourcePixels, pagePixels);
+    return 0;
+}
@@ -7,6 +7,57 @@
 // Scale factor for art (2.0 means 16x16 becomes 32x32)
 #define PIXEL_SCALE 2.0f
 
+// Draw the world at the art's resolution and scale it up to the window once
+// (world_view.h), WORLD_INTEGER_SCALE keeps that scale a whole number
+#define NATIVE_RESOLUTION_RENDER 1
+#define WORLD_INTEGER_SCALE 1
+
+// Arena block sizes for map, tileset and chunk collision data (arena.h)
+#define MAP_ARENA_BLOCK (64 * 1024)
+#define TILESET_ARENA_BLOCK (16 * 1024)
+#define CHUNK_COLLISION_ARENA_BLOCK (8 * 1024)
+
+// Upper bound for the threads that parse tilesets and decode images
+#define MAX_ASSET_WORKERS 8
+
+// Bytes of decoded chunks (and their tile collision) an infinite map keeps
+// around the camera
+#define CHUNK_MEMORY_BUDGET (4 * 1024 * 1024)
+
+// Tile layers are baked into render textures of BAKE_CHUNK_TILES square
+// tiles, at most BAKE_MEMORY_BUDGET bytes of them are kept (map_render.h)
+#define BAKE_CHUNK_TILES 32
+#define BAKE_MEMORY_BUDGET (32 * 1024 * 1024)
+
+// Most map polygons a leaf of the collision hierarchy holds, the side of a
+// collision grid cell in art pixels and the most cells the grid may have
+// before its cells get bigger (map_collision.h)
+#define COLLISION_LEAF_SHAPES 4
+#define COLLISION_CELL_PIXELS 4
+#define COLLISION_GRID_MAX_CELLS (16 * 1024 * 1024)
+
+// Side of a cell of the entity collision broadphase in world pixels, about
+// the size of a monster (entity_manager.h)
+#define ENTITY_CELL_SIZE 64.0f
+
+// Tile objects are grouped into square buckets of OBJECT_BUCKET_TILES
+// tiles so drawing only looks at the ones near the view (map_objects.h)
+#define OBJECT_BUCKET_TILES 8
+
+// Texture atlas built by atlaspack (texture_atlas.h): where the game looks
+// for it, the largest page and the transparent gap between packed images
+#define TEXTURE_ATLAS_PATH "SproutLandsPack/atlas.txt"
+#define ATLAS_PAGE_SIZE 1024
+#define ATLAS_PADDING 2
+
+// Unused tilesets kept loaded for the next map that needs them
+#define TILESET_CACHE_SIZE 8
+
+// Maps kept loaded besides the current one, and how close (world pixels)
+// the player gets to a MapTransition before its target starts loading
+#define MAP_CACHE_SIZE 4
+#define MAP_PREFETCH_DISTANCE 160.0f
+
 // Draw grid lines over every tile
 #define DEBUG_GRID 1
 //draw collision polygons
@@ -15,6 +66,8 @@
 #define DEBUG_DRAW_PLAYER_COLLISION 1
 //draw MapTransition polygons
 #define DEBUG_DRAW_MAPTRANSITIONS 1
+//draw how many tiles/chunks/entities were drawn and culled, and the draw calls, last frame
+#define DEBUG_DRAW_RENDER_STATS 1
 
 // Entity movement control
 extern int ENTITIES_CAN_MOVE;  // Remove the #define and make it extern
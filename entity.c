@@ -3,25 +3,56 @@
 #include <stdlib.h>
 #include <math.h>
 #include "map_manager.h"
+#include "map_collision.h"
+#include "render_queue.h"
 
 
-void InitEntitySprite(EntitySprite* sprite, const char* texturePath, int rows, int columns, float frameDelay) {
-    sprite->texture = LoadTexture(texturePath);
+static void SetEntitySpriteFrames(void* user) {
+    EntitySprite* sprite = (EntitySprite*)user;
+    int width = sprite->atlas ? sprite->atlas->width : sprite->texture.width;
+    int height = sprite->atlas ? sprite->atlas->height : sprite->texture.height;
+    sprite->frameWidth = width / sprite->columns;
+    sprite->frameHeight = height / sprite->rows;
+}
+
+void QueueEntitySprite(TextureBatch* batch, EntitySprite* sprite, const char* texturePath, int rows, int columns, float frameDelay) {
+    sprite->texture = (Texture2D){0};
     sprite->rows = rows;
     sprite->columns = columns;
-    sprite->frameWidth = sprite->texture.width / columns;
-    sprite->frameHeight = sprite->texture.height / rows;
+    sprite->frameWidth = 0;
+    sprite->frameHeight = 0;
     sprite->currentFrame = 0;
     sprite->frameTime = 0;
     sprite->frameDelay = frameDelay;
     sprite->currentRow = 0;
+    sprite->atlas = FindAtlasImage(texturePath);
+    if (sprite->atlas) {
+        sprite->texture = sprite->atlas->texture;
+        SetEntitySpriteFrames(sprite);
+        return;
+    }
+    QueueTexture(batch, texturePath, &sprite->texture, SetEntitySpriteFrames, sprite);
+}
+
+void InitEntitySprite(EntitySprite* sprite, const char* texturePath, int rows, int columns, float frameDelay) {
+    QueueEntitySprite(NULL, sprite, texturePath, rows, columns, frameDelay);
 }
 
 void UnloadEntitySprite(EntitySprite* sprite) {
     if (sprite->texture.id != 0) {
-        UnloadTexture(sprite->texture);
+        ReleaseTexture(sprite->texture);
         sprite->texture.id = 0;
     }
+    sprite->atlas = NULL;
+}
+
+Rectangle GetEntityDrawRect(const Entity* entity) {
+    return (Rectangle){
+        entity->physics.position.x,
+        entity->physics.position.y,
+        entity->sprite.frameWidth * entity->physics.scale,
+        entity->sprite.frameHeight * entity->physics.scale
+    };
 }
 
 Rectangle GetEntityCollisionRect(const Entity* entity) {
@@ -67,21 +98,9 @@ void UpdateBasicMonster(Entity* entity, GameMap* map, float dt) {
         
         // Check collision with map
         Rectangle entityRect = GetEntityCollisionRect(entity);
-        for (int i = 0; i < map->collisionLayer.count; i++) {
-            Polygon poly = map->collisionLayer.polygons[i];
-            if (poly.pointCount < 2) continue;
-            
-            Vector2 worldPoly[128];
-            for (int j = 0; j < poly.pointCount; j++) {
-                worldPoly[j].x = poly.points[j].x * PIXEL_SCALE;
-                worldPoly[j].y = poly.points[j].y * PIXEL_SCALE;
-            }
-            
-            if (CheckCollisionPolyRectangle(worldPoly, poly.pointCount, entityRect)) {
-                entity->physics.position = oldPos;
-                data->moveTimer = data->moveInterval; // Force new direction
-                break;
-            }
+        if (CheckSolidRec(map, entityRect)) {
+            entity->physics.position = oldPos;
+            data->moveTimer = data->moveInterval; // Force new direction
         }
     }
     
@@ -120,26 +139,10 @@ void UpdateAggressiveMonster(Entity* entity, GameMap* map, float dt) {
         
         // Check collision and bounce
         Rectangle entityRect = GetEntityCollisionRect(entity);
-        for (int i = 0; i < map->collisionLayer.count; i++) {
-            Polygon poly = map->collisionLayer.polygons[i];
-            if (poly.pointCount < 2) continue;
-            
-            Vector2 worldPoly[128];
-            for (int j = 0; j < poly.pointCount; j++) {
-                worldPoly[j].x = poly.points[j].x * entity->physics.scale;
-                worldPoly[j].y = poly.points[j].y * entity->physics.scale;
-            }
-            
-            if (CheckCollisionRecs(entityRect, (Rectangle){
-                worldPoly[0].x, worldPoly[0].y,
-                worldPoly[1].x - worldPoly[0].x,
-                worldPoly[1].y - worldPoly[0].y
-            })) {
-                entity->physics.position = oldPos;
-                data->moveDirection.x *= -1;
-                data->moveDirection.y *= -1;
-                break;
-            }
+        if (CheckSolidRec(map, entityRect)) {
+            entity->physics.position = oldPos;
+            data->moveDirection.x *= -1;
+            data->moveDirection.y *= -1;
         }
     }
     
@@ -172,32 +175,24 @@ void DrawMonster(Entity* entity) {
         entity->sprite.frameHeight * entity->physics.scale
     };
     
-    DrawTexturePro(entity->sprite.texture, srcRec, destRec, (Vector2){0, 0}, 0.0f, WHITE);
+    // sorted by the feet so lower sprites cover higher ones
+    float depth = destRec.y + destRec.height;
+    if (!entity->sprite.atlas || MapAtlasRect(entity->sprite.atlas, &srcRec, &destRec))
+        QueueSprite(RENDER_LAYER_ENTITIES, depth, entity->sprite.texture,
+                    srcRec, destRec, (Vector2){0, 0}, 0.0f, WHITE);
     
     // Draw debug collision box
     #if DEBUG_DRAW_ENTITY_COLLISION
         Rectangle collisionRect = GetEntityCollisionRect(entity);
         Color boxColor = entity->physics.hitFlashTimer > 0 ? 
                         entity->physics.hitFlashColor : GREEN;
-        DrawRectangleLines(
-            (int)collisionRect.x, 
-            (int)collisionRect.y, 
-            (int)collisionRect.width, 
-            (int)collisionRect.height, 
-            boxColor
-        );
+        QueueRectangleLines(RENDER_LAYER_DEBUG, 0.0f, collisionRect, boxColor);
     #endif
 
     // Draw attack hitbox if attacking
     #if DEBUG_DRAW_ATTACK_HITBOX
         if (entity->physics.isAttacking) {
-            DrawRectangleLines(
-                (int)entity->physics.attackHitbox.x,
-                (int)entity->physics.attackHitbox.y,
-                (int)entity->physics.attackHitbox.width,
-                (int)entity->physics.attackHitbox.height,
-                RED
-            );
+            QueueRectangleLines(RENDER_LAYER_DEBUG, 0.0f, entity->physics.attackHitbox, RED);
         }
     #endif
 }
@@ -307,25 +302,13 @@ void RenderEntityDebug(const Entity* entity) {
         Rectangle collisionRect = GetEntityCollisionRect(entity);
         Color boxColor = entity->physics.hitFlashTimer > 0 ? 
                         entity->physics.hitFlashColor : GREEN;
-        DrawRectangleLines(
-            (int)collisionRect.x, 
-            (int)collisionRect.y, 
-            (int)collisionRect.width, 
-            (int)collisionRect.height, 
-            boxColor
-        );
+        QueueRectangleLines(RENDER_LAYER_DEBUG, 0.0f, collisionRect, boxColor);
     #endif
 
     #if DEBUG_DRAW_ATTACK_HITBOX
         // Draw attack hitbox if attacking
         if (entity->physics.isAttacking) {
-            DrawRectangleLines(
-                (int)entity->physics.attackHitbox.x,
-                (int)entity->physics.attackHitbox.y,
-                (int)entity->physics.attackHitbox.width,
-                (int)entity->physics.attackHitbox.height,
-                RED
-            );
+            QueueRectangleLines(RENDER_LAYER_DEBUG, 0.0f, entity->physics.attackHitbox, RED);
         }
     #endif
 }
@@ -380,36 +363,3 @@ void EntityTakeHit(Entity* entity) {
     entity->physics.hitFlashTimer = 0.2f; // Flash for 0.2 seconds
     entity->physics.hitFlashColor = RED;
 }
-
-int CheckCollisionPolyRectangle(Vector2* poly, int polyCount, Rectangle rec) {
-    Vector2 corners[4] = {
-        { rec.x, rec.y },
-        { rec.x + rec.width, rec.y },
-        { rec.x + rec.width, rec.y + rec.height },
-        { rec.x, rec.y + rec.height }
-    };
-    
-    // Check if any corner of the rectangle is inside the polygon
-    for (int i = 0; i < 4; i++) {
-        if (CheckCollisionPointPoly(corners[i], poly, polyCount)) {
-            return 1;
-        }
-    }
-    
-    // Check if any polygon edge intersects with any rectangle edge
-    for (int i = 0; i < polyCount; i++) {
-        Vector2 p1 = poly[i];
-        Vector2 p2 = poly[(i + 1) % polyCount];
-        
-        for (int j = 0; j < 4; j++) {
-            Vector2 r1 = corners[j];
-            Vector2 r2 = corners[(j + 1) % 4];
-            
-            if (CheckCollisionLines(p1, p2, r1, r2, NULL)) {
-                return 1;
-            }
-        }
-    }
-    
-    return 0;
-} 
@@ -3,6 +3,8 @@
 
 #include "raylib.h"
 #include "tiled_loader.h"
+#include "asset_workers.h"
+#include "texture_atlas.h"
 #include "monster_types.h"
 
 // Forward declaration to avoid circular dependency
@@ -14,6 +16,7 @@ typedef struct Entity Entity;
 
 typedef struct EntitySprite {
     Texture2D texture;
+    const AtlasImage* atlas;  // where the sheet sits on texture, NULL when texture is the sheet
     int rows;
     int columns;
     int frameWidth;
@@ -85,8 +88,13 @@ extern int ENTITIES_CAN_MOVE;
 
 // Basic entity functions
 void InitEntitySprite(EntitySprite* sprite, const char* texturePath, int rows, int columns, float frameDelay);
+// same, but the sheet is decoded with the rest of the batch and the frame
+// size is only known after FinishTextureBatch
+void QueueEntitySprite(TextureBatch* batch, EntitySprite* sprite, const char* texturePath, int rows, int columns, float frameDelay);
 void UnloadEntitySprite(EntitySprite* sprite);
 Rectangle GetEntityCollisionRect(const Entity* entity);
+// area the sprite covers in world space, used to cull off-screen entities
+Rectangle GetEntityDrawRect(const Entity* entity);
 
 // Monster creation functions
 Entity* CreateBasicMonster(Vector2 position, float scale, const char* texturePath);
@@ -106,7 +114,4 @@ void RenderEntityDebug(const Entity* entity);
 void EntityStartAttack(Entity* entity);
 void EntityTakeHit(Entity* entity);
 
-// Helper function for collision detection
-int CheckCollisionPolyRectangle(Vector2* poly, int polyCount, Rectangle rec);
-
 #endif 
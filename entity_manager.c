@@ -1,5 +1,7 @@
 #include "entity_manager.h"
+#include "constants.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 EntityManager* CreateEntityManager(void) {
@@ -7,6 +9,11 @@ EntityManager* CreateEntityManager(void) {
     if (manager) {
         manager->count = 0;
         manager->player = NULL;
+        manager->cells = NULL;
+        manager->cellCapacity = 0;
+        manager->buckets = NULL;
+        manager->bucketCapacity = 0;
+        manager->collisionStats = (CollisionStats){ 0 };
         for (int i = 0; i < MAX_ENTITIES; i++) {
             manager->entities[i] = NULL;
         }
@@ -21,6 +28,8 @@ void DestroyEntityManager(EntityManager* manager) {
                 DestroyEntity(manager->entities[i]);
             }
         }
+        free(manager->cells);
+        free(manager->buckets);
         free(manager);
     }
 }
@@ -78,27 +87,18 @@ void UpdateEntities(EntityManager* manager, GameMap* map, float dt) {
     }
 }
 
-void DrawEntities(EntityManager* manager) {
-    // Sort entities by Y position for proper depth
-    // This is a simple bubble sort - could be optimized
-    for (int i = 0; i < manager->count - 1; i++) {
-        for (int j = 0; j < manager->count - i - 1; j++) {
-            if (manager->entities[j]->physics.position.y > 
-                manager->entities[j + 1]->physics.position.y) {
-                Entity* temp = manager->entities[j];
-                manager->entities[j] = manager->entities[j + 1];
-                manager->entities[j + 1] = temp;
-            }
-        }
-    }
-    
-    // Draw all entities
+int DrawEntities(EntityManager* manager, Rectangle view) {
+    // Draw the entities on screen
+    int drawn = 0;
     for (int i = 0; i < manager->count; i++) {
         Entity* entity = manager->entities[i];
-        if (entity->active && entity->isAlive && entity->draw) {
+        if (entity->active && entity->isAlive && entity->draw &&
+            CheckCollisionRecs(GetEntityDrawRect(entity), view)) {
             entity->draw(entity);
+            drawn++;
         }
     }
+    return drawn;
 }
 
 Entity* GetEntityAt(EntityManager* manager, Vector2 position) {
@@ -150,37 +150,166 @@ Entity** GetEntitiesByType(EntityManager* manager, int type, int* count) {
     return results;
 }
 
+// the narrow phase, both attack hitboxes then the collision rects
+static void CollidePair(EntityManager* manager, int i, int j) {
+    Entity* e1 = manager->entities[i];
+    Entity* e2 = manager->entities[j];
+    if (!e1->active || !e1->isAlive || !e2->active || !e2->isAlive) return;
+    Rectangle r1 = manager->bounds[i];
+    Rectangle r2 = manager->bounds[j];
+    manager->collisionStats.pairsTested++;
+
+    // Check attack hitbox collisions
+    if (e1->physics.isAttacking) {
+        if (CheckCollisionRecs(e1->physics.attackHitbox, r2)) {
+            EntityTakeHit(e2);
+            manager->collisionStats.hits++;
+        }
+    }
+
+    if (e2->physics.isAttacking) {
+        if (CheckCollisionRecs(e2->physics.attackHitbox, r1)) {
+            EntityTakeHit(e1);
+            manager->collisionStats.hits++;
+        }
+    }
+
+    // Regular collision handling
+    if (CheckCollisionRecs(r1, r2)) {
+        manager->collisionStats.overlaps++;
+        if (e1->onCollision) e1->onCollision(e1, e2);
+        if (e2->onCollision) e2->onCollision(e2, e1);
+    }
+}
+
+static int CellOf(float v) {
+    return (int)floorf(v / ENTITY_CELL_SIZE);
+}
+
+static unsigned int HashCell(int x, int y, unsigned int mask) {
+    return ((unsigned int)x * 73856093u ^ (unsigned int)y * 19349663u) & mask;
+}
+
+// grows the broadphase arrays, 0 when out of memory
+static int ReserveBroadphase(EntityManager* manager, int cells, int buckets) {
+    if (cells > manager->cellCapacity) {
+        EntityCell* grown = (EntityCell*)realloc(manager->cells, cells * sizeof(EntityCell));
+        if (!grown) return 0;
+        manager->cells = grown;
+        manager->cellCapacity = cells;
+    }
+    if (buckets > manager->bucketCapacity) {
+        unsigned int* grown = (unsigned int*)realloc(manager->buckets, (buckets + 1) * sizeof(unsigned int));
+        if (!grown) return 0;
+        manager->buckets = grown;
+        manager->bucketCapacity = buckets;
+    }
+    return 1;
+}
+
 void CheckCollisions(EntityManager* manager) {
-    for (int i = 0; i < manager->count; i++) {
-        Entity* e1 = manager->entities[i];
-        if (!e1->active || !e1->isAlive) continue;
-        
-        Rectangle r1 = GetEntityCollisionRect(e1);
-        
-        for (int j = i + 1; j < manager->count; j++) {
-            Entity* e2 = manager->entities[j];
-            if (!e2->active || !e2->isAlive) continue;
-            
-            Rectangle r2 = GetEntityCollisionRect(e2);
-            
-            // Check attack hitbox collisions
-            if (e1->physics.isAttacking) {
-                if (CheckCollisionRecs(e1->physics.attackHitbox, r2)) {
-                    EntityTakeHit(e2);
+    manager->collisionStats = (CollisionStats){ 0 };
+    int count = manager->count;
+
+    // cache the rects, and count the cells every reach box covers
+    int cellCount = 0;
+    for (int i = 0; i < count; i++) {
+        Entity* entity = manager->entities[i];
+        if (!entity->active || !entity->isAlive) {
+            manager->bounds[i].width = -1.0f;
+            continue;
+        }
+        Rectangle rect = GetEntityCollisionRect(entity);
+        Rectangle reach = rect;
+        if (entity->physics.isAttacking) {
+            Rectangle hit = entity->physics.attackHitbox;
+            float right = fmaxf(rect.x + rect.width, hit.x + hit.width);
+            float bottom = fmaxf(rect.y + rect.height, hit.y + hit.height);
+            reach.x = fminf(rect.x, hit.x);
+            reach.y = fminf(rect.y, hit.y);
+            reach.width = right - reach.x;
+            reach.height = bottom - reach.y;
+        }
+        manager->bounds[i] = rect;
+        manager->reach[i] = reach;
+        cellCount += (CellOf(reach.x + reach.width) - CellOf(reach.x) + 1) *
+                     (CellOf(reach.y + reach.height) - CellOf(reach.y) + 1);
+    }
+    int bucketCount = 16;
+    while (bucketCount < cellCount) bucketCount *= 2;
+    if (!ReserveBroadphase(manager, cellCount, bucketCount)) {
+        // every pair still works, just slowly
+        for (int i = 0; i < count; i++) {
+            if (manager->bounds[i].width < 0.0f) continue;
+            for (int j = i + 1; j < count; j++) {
+                if (manager->bounds[j].width >= 0.0f)
+                    CollidePair(manager, i, j);
+            }
+        }
+        return;
+    }
+
+    // counting sort of the cells by bucket
+    unsigned int mask = (unsigned int)bucketCount - 1;
+    unsigned int* buckets = manager->buckets;
+    memset(buckets, 0, (bucketCount + 1) * sizeof(unsigned int));
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < count; i++) {
+            if (manager->bounds[i].width < 0.0f) continue;
+            Rectangle reach = manager->reach[i];
+            int x1 = CellOf(reach.x + reach.width), y1 = CellOf(reach.y + reach.height);
+            for (int y = CellOf(reach.y); y <= y1; y++) {
+                for (int x = CellOf(reach.x); x <= x1; x++) {
+                    unsigned int bucket = HashCell(x, y, mask);
+                    if (pass == 0)
+                        buckets[bucket]++;
+                    else
+                        manager->cells[--buckets[bucket]] = (EntityCell){ x, y, i };
                 }
             }
-            
-            if (e2->physics.isAttacking) {
-                if (CheckCollisionRecs(e2->physics.attackHitbox, r1)) {
-                    EntityTakeHit(e1);
+        }
+        // ends after the first pass, filled back to front so starts after the second
+        if (pass == 0) {
+            for (int b = 1; b <= bucketCount; b++)
+                buckets[b] += buckets[b - 1];
+        }
+    }
+
+    // Pairs sharing several cells are only taken in the one holding the
+    // top-left corner of where their reach boxes overlap
+    int* partners = manager->partners;
+    for (int i = 0; i < count; i++) {
+        if (manager->bounds[i].width < 0.0f) continue;
+        int partnerCount = 0;
+        Rectangle a = manager->reach[i];
+        int x1 = CellOf(a.x + a.width), y1 = CellOf(a.y + a.height);
+        for (int y = CellOf(a.y); y <= y1; y++) {
+            for (int x = CellOf(a.x); x <= x1; x++) {
+                unsigned int bucket = HashCell(x, y, mask);
+                for (unsigned int k = buckets[bucket]; k < buckets[bucket + 1]; k++) {
+                    const EntityCell* cell = &manager->cells[k];
+                    int j = cell->entity;
+                    if (j <= i || cell->cellX != x || cell->cellY != y) continue;
+                    Rectangle b = manager->reach[j];
+                    if (a.x > b.x + b.width || b.x > a.x + a.width ||
+                        a.y > b.y + b.height || b.y > a.y + a.height)
+                        continue;
+                    if (CellOf(fmaxf(a.x, b.x)) != x || CellOf(fmaxf(a.y, b.y)) != y) continue;
+                    partners[partnerCount++] = j;
                 }
             }
-            
-            // Regular collision handling
-            if (CheckCollisionRecs(r1, r2)) {
-                if (e1->onCollision) e1->onCollision(e1, e2);
-                if (e2->onCollision) e2->onCollision(e2, e1);
+        }
+        // cells come in grid order and hold entities back to front, but a
+        // hit can kill an entity so pairs go in update order, like i < j
+        for (int k = 1; k < partnerCount; k++) {
+            int j = partners[k], at = k;
+            while (at > 0 && partners[at - 1] > j) {
+                partners[at] = partners[at - 1];
+                at--;
             }
+            partners[at] = j;
         }
+        for (int k = 0; k < partnerCount; k++)
+            CollidePair(manager, i, partners[k]);
     }
-} 
\ No newline at end of file
+}
@@ -5,12 +5,34 @@
 #include "monster.h"
 #include "tiled_loader.h"
 
-#define MAX_ENTITIES 100
+#define MAX_ENTITIES 4096
+
+// what the last CheckCollisions did
+typedef struct {
+    int pairsTested;   // pairs sharing a broadphase cell
+    int overlaps;      // pairs whose collision rects overlap
+    int hits;          // attack hitboxes that reached another entity
+} CollisionStats;
+
+// one entity in one broadphase cell
+typedef struct {
+    int cellX, cellY;
+    int entity;        // index in entities
+} EntityCell;
 
 typedef struct {
     Entity* entities[MAX_ENTITIES];
     int count;
     Entity* player; // Reference to player entity
+    // CheckCollisions broadphase, rebuilt on every call
+    Rectangle bounds[MAX_ENTITIES]; // collision rect, width < 0 for entities that take no part
+    Rectangle reach[MAX_ENTITIES];  // bounds grown to cover the attack hitbox
+    int partners[MAX_ENTITIES];     // later entities one entity is tested against, sorted
+    EntityCell* cells;              // grouped by bucket
+    int cellCapacity;
+    unsigned int* buckets;          // bucketCount + 1 starts into cells
+    int bucketCapacity;
+    CollisionStats collisionStats;
 } EntityManager;
 
 // Creation and destruction
@@ -24,14 +46,19 @@ void RemoveDeadEntities(EntityManager* manager);
 
 // Update and render
 void UpdateEntities(EntityManager* manager, GameMap* map, float dt);
-void DrawEntities(EntityManager* manager);
+// queues the entities overlapping view (world space), returns how many. The
+// render queue puts them back to front by their feet
+int DrawEntities(EntityManager* manager, Rectangle view);
 
 // Entity queries
 Entity* GetEntityAt(EntityManager* manager, Vector2 position);
 Entity** GetEntitiesInRange(EntityManager* manager, Vector2 position, float range, int* count);
 Entity** GetEntitiesByType(EntityManager* manager, int type, int* count);
 
-// Collision detection
+// Collision detection. Entities are hashed into ENTITY_CELL_SIZE cells
+// by the box covering their collision rect and attack hitbox, and only
+// pairs sharing a cell are tested. Each pair is tested once, in the same
+// order as looping over every i < j, since a hit can kill an entity
 void CheckCollisions(EntityManager* manager);
 
 #endif 
\ No newline at end of file
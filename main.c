@@ -1,8 +1,14 @@
 #include "raylib.h"
 #include "map_manager.h"
+#include "constants.h"
+#include "tileset_registry.h"
+#include "asset_workers.h"
 #include "player.h"
+#include "render_queue.h"
+#include "texture_atlas.h"
 #include "entity_manager.h"
 #include "monster.h"
+#include "world_view.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -11,14 +17,19 @@ int main(void) {
     const int screenHeight = 600;
     InitWindow(screenWidth, screenHeight, "Map Manager Demo");
     SetTargetFPS(60);
+    StartAssetWorkers(0);
+    // packed sprites and tilesets, anything missing from it loads on its own
+    LoadTextureAtlas(TEXTURE_ATLAS_PATH);
     
-    // Initialize player
+    // Initialize player, its sprite sheet decodes while the first map loads
     Vector2 startPos = { (screenWidth - 192 * 2) / 2.0f, (screenHeight - 192 * 2) / 2.0f };
     Player player;
-    InitPlayer(&player, "SproutLandsPack/Characters/BasicCharakterSpritesheet.png", startPos, 2.0f);
+    TextureBatch* startup = BeginTextureBatch();
+    InitPlayer(&player, "SproutLandsPack/Characters/BasicCharakterSpritesheet.png", startPos, 2.0f, startup);
     
     // Create map manager
     MapManager* mapManager = CreateMapManager("Tiled/Tiledmaps/field.tmj");
+    FinishTextureBatch(startup);
     
     // Camera setup
     Camera2D camera = { 0 };
@@ -29,12 +40,16 @@ int main(void) {
     camera.offset = (Vector2){ screenWidth / 2.0f, screenHeight / 2.0f };
     camera.rotation = 0.0f;
     camera.zoom = 1.0f;
+
+    // world drawn at the art's resolution, scaled up to the window once
+    WorldView worldView;
+    InitWorldView(&worldView, PIXEL_SCALE, WORLD_INTEGER_SCALE);
     
     while (!WindowShouldClose()) {
         float dt = GetFrameTime();
         
         // Update player first
-        UpdatePlayer(&player, &mapManager->currentMap, dt);
+        UpdatePlayer(&player, mapManager->currentMap, dt);
         
         // Update map manager (includes entity updates)
         UpdateMapManager(mapManager, &player, dt);
@@ -50,27 +65,53 @@ int main(void) {
             player.physics.position.x + (player.sprite.frameWidth * player.physics.scale) / 2.0f,
             player.physics.position.y + (player.sprite.frameHeight * player.physics.scale) / 2.0f
         };
+        FitWorldView(&worldView, &camera);
+
+        // Decode chunks of infinite maps around the new view
+        UpdateMapStreaming(mapManager, camera, player.physics.scale);
         
         BeginDrawing();
             ClearBackground((Color){200, 255, 200, 255});
             
-            BeginMode2D(camera);
+            BeginWorldView(&worldView, camera, (Color){200, 255, 200, 255});
+                BeginRenderQueue();
                 // Render map and entities
-                RenderMapManager(mapManager, player.physics.scale);
+                RenderMapManager(mapManager, camera, player.physics.scale);
                 
                 // Draw player
                 DrawPlayer(&player);
-            EndMode2D();
+                FlushRenderQueue();
+            EndWorldView(&worldView);
             
             // Draw UI
             DrawText(TextFormat("Current Map: %s", mapManager->currentMapName), 
                     10, 10, 20, BLACK);
+            #if DEBUG_DRAW_RENDER_STATS
+            RenderStats stats = mapManager->renderStats;
+            DrawText(TextFormat("Chunks %d (culled %d, baked %d)  Tiles %d (culled %d)  Objects %d (culled %d)  Entities %d (culled %d)",
+                    stats.chunksDrawn, stats.chunksCulled, stats.chunksBaked,
+                    stats.tilesDrawn, stats.tilesCulled, stats.objectsDrawn, stats.objectsCulled,
+                    stats.entitiesDrawn, stats.entitiesCulled),
+                    10, 35, 10, BLACK);
+            RenderQueueStats queueStats = GetRenderQueueStats();
+            DrawText(TextFormat("Draw calls %d  Texture binds %d", queueStats.drawCalls, queueStats.textureBinds),
+                    10, 50, 10, BLACK);
+            CollisionStats collisionStats = mapManager->entityManager->collisionStats;
+            DrawText(TextFormat("Entity pairs tested %d  Overlaps %d  Hits %d", collisionStats.pairsTested,
+                    collisionStats.overlaps, collisionStats.hits),
+                    10, 65, 10, BLACK);
+            #endif
         EndDrawing();
     }
     
     // Cleanup
     DestroyMapManager(mapManager);
+    UnloadWorldView(&worldView);
+    StopAssetWorkers();
+    UnloadRenderQueue();
+    UnloadTilesetRegistry();
     UnloadPlayer(&player);
+    UnloadTextureAtlas();
     CloseWindow();
     
     return 0;
@@ -0,0 +1,887 @@
+#include "map_binary.h"
+#include "map_chunks.h"
+#include "tileset_registry.h"
+#include "constants.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// On disk layout, every offset is from the start of the file.
+// header | tilesets | layers | polygons | transitions | tile collisions | tile polygons |
+// tile animations | tile frames | tile objects | object buckets | runs | points |
+// tiles | flips | chunks | strings
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t fileSize;
+    uint32_t stringsOffset;
+    int64_t sourceModTime;
+    int32_t mapWidth, mapHeight;
+    int32_t tileWidth, tileHeight;
+    uint32_t tilesetCount, tilesetOffset;
+    uint32_t layerCount, layerOffset;
+    uint32_t collisionCount, collisionOffset;
+    uint32_t transitionCount, transitionOffset;
+    uint32_t tileCollisionCount, tileCollisionOffset;
+    uint32_t tilePolygonCount, tilePolygonOffset;
+    uint32_t tileAnimationCount, tileAnimationOffset;
+    uint32_t tileFrameCount, tileFrameOffset;
+    uint32_t tileObjectCount, tileObjectOffset; // TileObjects, read in place
+    uint32_t objectBucketOffset;  // objectGridWidth * objectGridHeight + 1 uint32 starts
+    int32_t objectBucketSize;
+    int32_t objectGridX, objectGridY;
+    int32_t objectGridWidth, objectGridHeight;
+    float objectReachX, objectReachY;
+} BlobHeader;
+
+typedef struct {
+    int32_t firstgid;
+    int32_t tileWidth, tileHeight;
+    int32_t imageWidth, imageHeight;
+    int32_t tileCount;
+    uint32_t sourceString;
+    uint32_t imageString;    // 0 when the tileset has no image
+    uint32_t firstTileCollision;
+    uint32_t tileCollisionCount; // only tiles that have shapes, by tile id
+    uint32_t firstTileAnimation;
+    uint32_t tileAnimationCount; // by tile id
+    int64_t sourceModTime;
+    int64_t imageModTime;    // mapc drops tiles by the image's alpha, so an edited image makes the blob stale
+} BlobTileset;
+
+typedef struct {
+    int32_t width, height;
+    uint32_t tilesOffset;    // uint16 TileIds, same layout as TileLayer.tiles
+    uint32_t flipsOffset;    // one TILE_FLIP_* byte per tile, 0 when nothing is flipped
+    int32_t originX, originY;
+    uint32_t chunkCount;     // infinite layers, tilesOffset is 0 then
+    uint32_t chunkOffset;    // BlobChunk table
+    uint32_t tileCount;      // TileIds at tilesOffset
+    uint32_t runCount;       // TileRun table of a sparse layer
+    uint32_t runsOffset;
+    uint32_t rowRunsOffset;  // height + 1 uint32 run indices, 0 for dense layers
+} BlobLayer;
+
+// a chunk decoded by the compiler, loaded as TILE_CHUNK_RAW
+typedef struct {
+    int32_t x, y;
+    int32_t width, height;
+    uint32_t tilesOffset;
+    uint32_t flipsOffset;
+} BlobChunk;
+
+typedef struct {
+    uint32_t pointsOffset;   // float x, y pairs
+    int32_t pointCount;
+} BlobPolygon;
+
+typedef struct {
+    uint32_t targetString;
+    float startX, startY;
+    BlobPolygon trigger;
+} BlobTransition;
+
+typedef struct {
+    int32_t tileId;
+    uint32_t firstPolygon;   // into the tile polygon table
+    int32_t polygonCount;
+} BlobTileCollision;
+
+typedef struct {
+    int32_t tileId;
+    uint32_t firstFrame;     // into the tile frame table
+    int32_t frameCount;
+} BlobTileAnimation;
+
+typedef struct {
+    int32_t tileId;
+    int32_t duration;
+} BlobTileFrame;
+
+_Static_assert(sizeof(BlobHeader) == 144, "BlobHeader layout");
+_Static_assert(sizeof(BlobTileset) == 64, "BlobTileset layout");
+_Static_assert(sizeof(BlobTileFrame) == sizeof(TileFrame), "frames are copied as is");
+_Static_assert(sizeof(BlobLayer) == 48, "BlobLayer layout");
+_Static_assert(sizeof(TileRun) == 8 && sizeof(unsigned int) == sizeof(uint32_t), "runs are read in place");
+_Static_assert(sizeof(Vector2) == 2 * sizeof(float), "points are read in place");
+_Static_assert(sizeof(TileId) == sizeof(uint16_t), "tiles are read in place");
+_Static_assert(sizeof(TileObject) == 20, "tile objects are read in place");
+
+static int HostIsLittleEndian(void) {
+    const uint16_t probe = 1;
+    return *(const uint8_t*)&probe == 1;
+}
+
+void GetCompiledMapPath(const char* mapFilePath, char* out, int outSize) {
+    snprintf(out, outSize, "%s", mapFilePath);
+    char* ext = strrchr(out, '.');
+    char* slash = strrchr(out, '/');
+    if (ext && (!slash || ext > slash))
+        *ext = '\0';
+    size_t len = strlen(out);
+    if (len + 5 <= (size_t)outSize)
+        strcpy(out + len, ".tmb");
+}
+
+long long GetSourceModTime(const char* path) {
+    struct stat st;
+    if (stat(path, &st) != 0)
+        return -1;
+    return (long long)st.st_mtime;
+}
+
+// MARK- Writer
+
+// growable byte buffer, values are stored little-endian regardless of host
+typedef struct {
+    unsigned char* data;
+    size_t size;
+    size_t capacity;
+} ByteBuffer;
+
+static void Reserve(ByteBuffer* buf, size_t extra) {
+    if (buf->size + extra <= buf->capacity) return;
+    size_t cap = buf->capacity ? buf->capacity : 4096;
+    while (cap < buf->size + extra) cap *= 2;
+    buf->data = (unsigned char*)realloc(buf->data, cap);
+    buf->capacity = cap;
+}
+
+static uint32_t Tell(const ByteBuffer* buf) {
+    return (uint32_t)buf->size;
+}
+
+static void Align(ByteBuffer* buf, size_t alignment) {
+    size_t pad = (alignment - buf->size % alignment) % alignment;
+    Reserve(buf, pad);
+    memset(buf->data + buf->size, 0, pad);
+    buf->size += pad;
+}
+
+static void PutBytes(ByteBuffer* buf, const void* bytes, size_t count) {
+    Reserve(buf, count);
+    memcpy(buf->data + buf->size, bytes, count);
+    buf->size += count;
+}
+
+static void PutU32(ByteBuffer* buf, uint32_t v) {
+    unsigned char b[4] = { v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, (v >> 24) & 0xFF };
+    PutBytes(buf, b, 4);
+}
+
+static void PutU16(ByteBuffer* buf, uint16_t v) {
+    unsigned char b[2] = { v & 0xFF, (v >> 8) & 0xFF };
+    PutBytes(buf, b, 2);
+}
+
+static void PutI32(ByteBuffer* buf, int32_t v) {
+    PutU32(buf, (uint32_t)v);
+}
+
+static void PutI64(ByteBuffer* buf, int64_t v) {
+    PutU32(buf, (uint32_t)((uint64_t)v & 0xFFFFFFFFu));
+    PutU32(buf, (uint32_t)((uint64_t)v >> 32));
+}
+
+static void PutF32(ByteBuffer* buf, float f) {
+    uint32_t v;
+    memcpy(&v, &f, 4);
+    PutU32(buf, v);
+}
+
+static void PatchU32(ByteBuffer* buf, uint32_t at, uint32_t v) {
+    unsigned char b[4] = { v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, (v >> 24) & 0xFF };
+    memcpy(buf->data + at, b, 4);
+}
+
+// strings are appended after everything else, offsets are relative to the string table
+static uint32_t PutString(ByteBuffer* strings, const char* s) {
+    if (!s) return 0;
+    uint32_t at = Tell(strings);
+    PutBytes(strings, s, strlen(s) + 1);
+    return at;
+}
+
+// tiles stored inline in the layer table, chunked layers have none
+static int LayerTileCount(const TileLayer* layer) {
+    return layer->tiles ? layer->tileCount : 0;
+}
+
+// run table plus row index of a sparse layer
+static uint32_t LayerRunBytes(const TileLayer* layer) {
+    if (!layer->tiles || !layer->rowRuns) return 0;
+    return layer->rowRuns[layer->height] * sizeof(TileRun) + (layer->height + 1) * sizeof(uint32_t);
+}
+
+// points of every polygon of a tile, they are stored back to back
+static int ShapePointCount(const TileShapes* shapes) {
+    int count = 0;
+    for (int p = 0; p < shapes->polygonCount; p++)
+        count += shapes->pointCounts[p];
+    return count;
+}
+
+// Chunk tables and their tiles go after the flips, the chunks are decoded
+// one at a time here so the game only ever reads them in place
+static void PutChunks(ByteBuffer* buf, GameMap* map, uint32_t layerOffset) {
+    for (int i = 0; i < map->tileLayerCount; i++) {
+        TileLayer* layer = &map->tileLayers[i];
+        if (layer->chunkCount == 0) continue;
+        Align(buf, 4);
+        uint32_t table = Tell(buf);
+        PatchU32(buf, layerOffset + i * sizeof(BlobLayer) + 28, table);
+        for (int c = 0; c < layer->chunkCount; c++) {
+            PutI32(buf, layer->chunks[c].x);
+            PutI32(buf, layer->chunks[c].y);
+            PutI32(buf, layer->chunks[c].width);
+            PutI32(buf, layer->chunks[c].height);
+            PutU32(buf, 0);
+            PutU32(buf, 0);
+        }
+        for (int c = 0; c < layer->chunkCount; c++) {
+            TileChunk* chunk = &layer->chunks[c];
+            uint32_t entry = table + c * sizeof(BlobChunk);
+            int count = chunk->width * chunk->height;
+            if (!LoadTileChunk(map, chunk)) continue;   // stays empty, like a missing chunk
+            PatchU32(buf, entry + 16, Tell(buf));
+            for (int t = 0; t < count; t++)
+                PutU16(buf, chunk->tiles[t]);
+            if (chunk->flips) {
+                PatchU32(buf, entry + 20, Tell(buf));
+                PutBytes(buf, chunk->flips, count);
+            }
+            Align(buf, 4);
+            UnloadTileChunk(map, chunk);
+        }
+    }
+}
+
+static void PutPoints(ByteBuffer* buf, const Polygon* poly) {
+    for (int i = 0; i < poly->pointCount; i++) {
+        PutF32(buf, poly->points[i].x);
+        PutF32(buf, poly->points[i].y);
+    }
+}
+
+int SaveMapBinary(GameMap* map, const char* sourcePath, const char* path) {
+    ByteBuffer buf = {0};
+    ByteBuffer strings = {0};
+    PutBytes(&strings, "", 1); // offset 0 is the empty/NULL string
+
+    // count tileset collision polygons so every table size is known up front
+    uint32_t tileCollisionCount = 0, tilePolygonCount = 0;
+    uint32_t tileAnimationCount = 0, tileFrameCount = 0;
+    for (int i = 0; i < map->tilesetCount; i++) {
+        tileCollisionCount += map->tilesets[i].shapeCount;
+        for (int t = 0; t < map->tilesets[i].shapeCount; t++)
+            tilePolygonCount += map->tilesets[i].shapes[t].polygonCount;
+        tileAnimationCount += map->tilesets[i].animationCount;
+        for (int a = 0; a < map->tilesets[i].animationCount; a++)
+            tileFrameCount += map->tilesets[i].animations[a].frameCount;
+    }
+
+    uint32_t tilesetOffset = sizeof(BlobHeader);
+    uint32_t layerOffset = tilesetOffset + map->tilesetCount * sizeof(BlobTileset);
+    uint32_t collisionOffset = layerOffset + map->tileLayerCount * sizeof(BlobLayer);
+    uint32_t transitionOffset = collisionOffset + map->collisionLayer.count * sizeof(BlobPolygon);
+    uint32_t tileCollisionOffset = transitionOffset + map->transitionCount * sizeof(BlobTransition);
+    uint32_t tilePolygonOffset = tileCollisionOffset + tileCollisionCount * sizeof(BlobTileCollision);
+    uint32_t tileAnimationOffset = tilePolygonOffset + tilePolygonCount * sizeof(BlobPolygon);
+    uint32_t tileFrameOffset = tileAnimationOffset + tileAnimationCount * sizeof(BlobTileAnimation);
+    uint32_t tileObjectOffset = tileFrameOffset + tileFrameCount * sizeof(BlobTileFrame);
+    uint32_t objectBucketOffset = tileObjectOffset + map->tileObjectCount * sizeof(TileObject);
+    uint32_t objectBucketCount = map->tileObjectCount > 0 ? map->objectGrid.width * map->objectGrid.height + 1 : 0;
+    uint32_t dataOffset = objectBucketOffset + objectBucketCount * sizeof(uint32_t);
+
+    // header, stringsOffset and fileSize get patched at the end
+    PutBytes(&buf, MAP_BLOB_MAGIC, 4);
+    PutU32(&buf, MAP_BLOB_VERSION);
+    PutU32(&buf, 0);
+    PutU32(&buf, 0);
+    PutI64(&buf, GetSourceModTime(sourcePath));
+    PutI32(&buf, map->mapWidth);
+    PutI32(&buf, map->mapHeight);
+    PutI32(&buf, map->tileWidth);
+    PutI32(&buf, map->tileHeight);
+    PutU32(&buf, map->tilesetCount);         PutU32(&buf, tilesetOffset);
+    PutU32(&buf, map->tileLayerCount);       PutU32(&buf, layerOffset);
+    PutU32(&buf, map->collisionLayer.count); PutU32(&buf, collisionOffset);
+    PutU32(&buf, map->transitionCount);      PutU32(&buf, transitionOffset);
+    PutU32(&buf, tileCollisionCount);        PutU32(&buf, tileCollisionOffset);
+    PutU32(&buf, tilePolygonCount);          PutU32(&buf, tilePolygonOffset);
+    PutU32(&buf, tileAnimationCount);        PutU32(&buf, tileAnimationOffset);
+    PutU32(&buf, tileFrameCount);            PutU32(&buf, tileFrameOffset);
+    PutU32(&buf, map->tileObjectCount);      PutU32(&buf, tileObjectOffset);
+    PutU32(&buf, objectBucketCount > 0 ? objectBucketOffset : 0);
+    PutI32(&buf, map->objectGrid.bucketSize);
+    PutI32(&buf, map->objectGrid.x);
+    PutI32(&buf, map->objectGrid.y);
+    PutI32(&buf, map->objectGrid.width);
+    PutI32(&buf, map->objectGrid.height);
+    PutF32(&buf, map->objectGrid.reachX);
+    PutF32(&buf, map->objectGrid.reachY);
+
+    // Variable sized data (runs, points, tiles) is laid out after the fixed
+    // tables, so compute where each block will land while writing the tables.
+    // 4 byte data first, then the 2 byte tile ids, then flip bytes, so
+    // nothing needs padding
+    uint32_t cursor = dataOffset;
+    uint32_t tilesCursor = dataOffset;
+    for (int i = 0; i < map->tileLayerCount; i++)
+        tilesCursor += LayerRunBytes(&map->tileLayers[i]);
+    for (int i = 0; i < map->collisionLayer.count; i++)
+        tilesCursor += map->collisionLayer.polygons[i].pointCount * 2 * sizeof(float);
+    for (int i = 0; i < map->transitionCount; i++)
+        tilesCursor += map->transitions[i].triggerArea.pointCount * 2 * sizeof(float);
+    for (int i = 0; i < map->tilesetCount; i++) {
+        for (int t = 0; t < map->tilesets[i].shapeCount; t++)
+            tilesCursor += ShapePointCount(&map->tilesets[i].shapes[t]) * 2 * sizeof(float);
+    }
+    uint32_t flipsCursor = tilesCursor;
+    for (int i = 0; i < map->tileLayerCount; i++)
+        flipsCursor += LayerTileCount(&map->tileLayers[i]) * sizeof(TileId);
+
+    uint32_t firstTileCollision = 0, firstTileAnimation = 0;
+    for (int i = 0; i < map->tilesetCount; i++) {
+        const Tileset* ts = &map->tilesets[i];
+        PutI32(&buf, ts->firstgid);
+        PutI32(&buf, ts->tileWidth);
+        PutI32(&buf, ts->tileHeight);
+        PutI32(&buf, ts->imageWidth);
+        PutI32(&buf, ts->imageHeight);
+        PutI32(&buf, ts->tileCount);
+        PutU32(&buf, PutString(&strings, ts->source));
+        PutU32(&buf, PutString(&strings, ts->imagePath));
+        PutU32(&buf, firstTileCollision);
+        PutU32(&buf, ts->shapeCount);
+        PutU32(&buf, firstTileAnimation);
+        PutU32(&buf, ts->animationCount);
+        PutI64(&buf, GetSourceModTime(ts->source));
+        PutI64(&buf, ts->imagePath ? GetSourceModTime(ts->imagePath) : -1);
+        firstTileCollision += ts->shapeCount;
+        firstTileAnimation += ts->animationCount;
+    }
+
+    for (int i = 0; i < map->tileLayerCount; i++) {
+        const TileLayer* layer = &map->tileLayers[i];
+        PutI32(&buf, layer->width);
+        PutI32(&buf, layer->height);
+        PutU32(&buf, layer->tiles ? tilesCursor : 0);
+        tilesCursor += LayerTileCount(layer) * sizeof(TileId);
+        PutU32(&buf, layer->tiles && layer->flips ? flipsCursor : 0);
+        if (layer->tiles && layer->flips)
+            flipsCursor += LayerTileCount(layer);
+        PutI32(&buf, layer->originX);
+        PutI32(&buf, layer->originY);
+        PutU32(&buf, layer->chunkCount);
+        PutU32(&buf, 0);   // patched by PutChunks
+        PutU32(&buf, LayerTileCount(layer));
+        if (LayerRunBytes(layer) > 0) {
+            uint32_t runCount = layer->rowRuns[layer->height];
+            PutU32(&buf, runCount);
+            PutU32(&buf, cursor);
+            PutU32(&buf, cursor + runCount * sizeof(TileRun));
+            cursor += LayerRunBytes(layer);
+        } else {
+            PutU32(&buf, 0);
+            PutU32(&buf, 0);
+            PutU32(&buf, 0);
+        }
+    }
+
+    for (int i = 0; i < map->collisionLayer.count; i++) {
+        PutU32(&buf, cursor);
+        PutI32(&buf, map->collisionLayer.polygons[i].pointCount);
+        cursor += map->collisionLayer.polygons[i].pointCount * 2 * sizeof(float);
+    }
+
+    for (int i = 0; i < map->transitionCount; i++) {
+        const MapTransition* tr = &map->transitions[i];
+        PutU32(&buf, PutString(&strings, tr->targetMap));
+        PutF32(&buf, tr->startX);
+        PutF32(&buf, tr->startY);
+        PutU32(&buf, cursor);
+        PutI32(&buf, tr->triggerArea.pointCount);
+        cursor += tr->triggerArea.pointCount * 2 * sizeof(float);
+    }
+
+    uint32_t firstPolygon = 0;
+    for (int i = 0; i < map->tilesetCount; i++) {
+        for (int t = 0; t < map->tilesets[i].shapeCount; t++) {
+            PutI32(&buf, map->tilesets[i].shapes[t].tileId);
+            PutU32(&buf, firstPolygon);
+            PutI32(&buf, map->tilesets[i].shapes[t].polygonCount);
+            firstPolygon += map->tilesets[i].shapes[t].polygonCount;
+        }
+    }
+    for (int i = 0; i < map->tilesetCount; i++) {
+        for (int t = 0; t < map->tilesets[i].shapeCount; t++) {
+            const TileShapes* shapes = &map->tilesets[i].shapes[t];
+            for (int p = 0; p < shapes->polygonCount; p++) {
+                PutU32(&buf, cursor);
+                PutI32(&buf, shapes->pointCounts[p]);
+                cursor += shapes->pointCounts[p] * 2 * sizeof(float);
+            }
+        }
+    }
+    uint32_t firstFrame = 0;
+    for (int i = 0; i < map->tilesetCount; i++) {
+        for (int a = 0; a < map->tilesets[i].animationCount; a++) {
+            const TileAnimation* animation = &map->tilesets[i].animations[a];
+            PutI32(&buf, animation->tileId);
+            PutU32(&buf, firstFrame);
+            PutI32(&buf, animation->frameCount);
+            firstFrame += animation->frameCount;
+        }
+    }
+    for (int i = 0; i < map->tilesetCount; i++) {
+        for (int a = 0; a < map->tilesets[i].animationCount; a++) {
+            const TileAnimation* animation = &map->tilesets[i].animations[a];
+            for (int f = 0; f < animation->frameCount; f++) {
+                PutI32(&buf, animation->frames[f].tileId);
+                PutI32(&buf, animation->frames[f].duration);
+            }
+        }
+    }
+    for (int i = 0; i < map->tileObjectCount; i++) {
+        const TileObject* obj = &map->tileObjects[i];
+        PutF32(&buf, obj->x);
+        PutF32(&buf, obj->y);
+        PutF32(&buf, obj->width);
+        PutF32(&buf, obj->height);
+        PutU16(&buf, obj->tile);
+        PutBytes(&buf, &obj->flip, 1);
+        PutBytes(&buf, "", 1);
+    }
+    for (uint32_t b = 0; b < objectBucketCount; b++)
+        PutU32(&buf, map->objectGrid.starts[b]);
+
+    // data blocks in the same order the tables above handed out offsets
+    for (int i = 0; i < map->tileLayerCount; i++) {
+        const TileLayer* layer = &map->tileLayers[i];
+        if (LayerRunBytes(layer) == 0) continue;
+        for (unsigned int r = 0; r < layer->rowRuns[layer->height]; r++) {
+            PutU16(&buf, layer->runs[r].x);
+            PutU16(&buf, layer->runs[r].length);
+            PutU32(&buf, layer->runs[r].first);
+        }
+        for (int y = 0; y <= layer->height; y++)
+            PutU32(&buf, layer->rowRuns[y]);
+    }
+    for (int i = 0; i < map->collisionLayer.count; i++)
+        PutPoints(&buf, &map->collisionLayer.polygons[i]);
+    for (int i = 0; i < map->transitionCount; i++)
+        PutPoints(&buf, &map->transitions[i].triggerArea);
+    for (int i = 0; i < map->tilesetCount; i++) {
+        for (int t = 0; t < map->tilesets[i].shapeCount; t++) {
+            const TileShapes* shapes = &map->tilesets[i].shapes[t];
+            Polygon all = { shapes->points, ShapePointCount(shapes) };
+            PutPoints(&buf, &all);
+        }
+    }
+
+    for (int i = 0; i < map->tileLayerCount; i++) {
+        const TileLayer* layer = &map->tileLayers[i];
+        for (int t = 0; t < LayerTileCount(layer); t++)
+            PutU16(&buf, layer->tiles[t]);
+    }
+    for (int i = 0; i < map->tileLayerCount; i++) {
+        const TileLayer* layer = &map->tileLayers[i];
+        if (layer->tiles && layer->flips)
+            PutBytes(&buf, layer->flips, LayerTileCount(layer));
+    }
+    cursor = flipsCursor;
+
+    if (Tell(&buf) != cursor) {
+        TraceLog(LOG_ERROR, "Compiled map layout mismatch for %s", path);
+        free(buf.data);
+        free(strings.data);
+        return 0;
+    }
+    PutChunks(&buf, map, layerOffset);
+
+    uint32_t stringsOffset = Tell(&buf);
+    PutBytes(&buf, strings.data, strings.size);
+    Align(&buf, 8);
+    PatchU32(&buf, 8, Tell(&buf));
+    PatchU32(&buf, 12, stringsOffset);
+    free(strings.data);
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        TraceLog(LOG_ERROR, "Failed to open %s for writing", path);
+        free(buf.data);
+        return 0;
+    }
+    size_t written = fwrite(buf.data, 1, buf.size, file);
+    fclose(file);
+    free(buf.data);
+    return written == buf.size;
+}
+
+// MARK- Loader
+
+static int InBounds(size_t fileSize, uint32_t offset, size_t bytes) {
+    return offset <= fileSize && bytes <= fileSize - offset;
+}
+
+static int PolygonInBounds(size_t fileSize, const BlobPolygon* poly) {
+    return poly->pointCount >= 0 &&
+           (poly->pointsOffset & 3) == 0 &&
+           InBounds(fileSize, poly->pointsOffset, (size_t)poly->pointCount * 2 * sizeof(float));
+}
+
+static Polygon BlobToPolygon(const unsigned char* base, const BlobPolygon* poly) {
+    Polygon p;
+    p.pointCount = poly->pointCount;
+    p.points = poly->pointCount > 0 ? (Vector2*)(base + poly->pointsOffset) : NULL;
+    return p;
+}
+
+// GetLayerTile and RenderRuns binary search the runs and index tiles with
+// them, so every run must be in its row, in order and inside the tiles
+static int SparseLayerIsValid(const unsigned char* base, size_t size, const BlobLayer* layer) {
+    if ((layer->runsOffset & 3) != 0 || (layer->rowRunsOffset & 3) != 0 ||
+        !InBounds(size, layer->runsOffset, (size_t)layer->runCount * sizeof(TileRun)) ||
+        !InBounds(size, layer->rowRunsOffset, ((size_t)layer->height + 1) * sizeof(uint32_t)))
+        return 0;
+    const TileRun* runs = (const TileRun*)(base + layer->runsOffset);
+    const uint32_t* rowRuns = (const uint32_t*)(base + layer->rowRunsOffset);
+    if (rowRuns[0] != 0 || rowRuns[layer->height] != layer->runCount) return 0;
+    for (int32_t y = 0; y < layer->height; y++) {
+        if (rowRuns[y + 1] < rowRuns[y]) return 0;
+        int32_t end = 0;
+        for (uint32_t r = rowRuns[y]; r < rowRuns[y + 1]; r++) {
+            if (runs[r].length == 0 || runs[r].x < end || runs[r].x + runs[r].length > layer->width ||
+                runs[r].first > layer->tileCount || runs[r].length > layer->tileCount - runs[r].first)
+                return 0;
+            end = runs[r].x + runs[r].length;
+        }
+    }
+    return 1;
+}
+
+// RenderTileObjects walks the buckets it overlaps and every object in them,
+// so the starts must cover exactly the object table
+static int ObjectGridIsValid(const unsigned char* base, size_t size, const BlobHeader* h) {
+    if (h->tileObjectCount == 0) return 1;
+    if ((h->tileObjectOffset & 3) != 0 || (h->objectBucketOffset & 3) != 0 ||
+        h->objectBucketSize <= 0 || h->objectGridWidth <= 0 || h->objectGridHeight <= 0 ||
+        !InBounds(size, h->tileObjectOffset, (size_t)h->tileObjectCount * sizeof(TileObject)))
+        return 0;
+    size_t buckets = (size_t)h->objectGridWidth * h->objectGridHeight;
+    if (buckets > size || !InBounds(size, h->objectBucketOffset, (buckets + 1) * sizeof(uint32_t)))
+        return 0;
+    const uint32_t* starts = (const uint32_t*)(base + h->objectBucketOffset);
+    if (starts[0] != 0 || starts[buckets] != h->tileObjectCount) return 0;
+    for (size_t b = 0; b < buckets; b++)
+        if (starts[b + 1] < starts[b]) return 0;
+    return 1;
+}
+
+// a heap copy of a compiled tileset the registry can own
+static Tileset CopyBlobTileset(const unsigned char* base, const BlobTileset* bts) {
+    const BlobHeader* h = (const BlobHeader*)base;
+    const BlobTileCollision* tcs = (const BlobTileCollision*)(base + h->tileCollisionOffset);
+    const BlobPolygon* tilePolys = (const BlobPolygon*)(base + h->tilePolygonOffset);
+    const BlobTileAnimation* animations = (const BlobTileAnimation*)(base + h->tileAnimationOffset);
+    const BlobTileFrame* frames = (const BlobTileFrame*)(base + h->tileFrameOffset);
+    const char* strings = (const char*)base + h->stringsOffset;
+    Tileset ts = {0};
+    ts.firstgid = bts->firstgid;
+    ts.tileWidth = bts->tileWidth;
+    ts.tileHeight = bts->tileHeight;
+    ts.imageWidth = bts->imageWidth;
+    ts.imageHeight = bts->imageHeight;
+    ts.tileCount = bts->tileCount;
+    ts.arena = CreateArena(TILESET_ARENA_BLOCK);
+    ts.source = ArenaStrdup(ts.arena, strings + bts->sourceString);
+    ts.imagePath = bts->imageString ? ArenaStrdup(ts.arena, strings + bts->imageString) : NULL;
+    // packed like LoadTileset does it, expanded by GetTileCollision
+    ts.shapeCount = bts->tileCollisionCount;
+    ts.shapes = (TileShapes*)ArenaAllocZero(ts.arena, (ts.shapeCount > 0 ? ts.shapeCount : 1) * sizeof(TileShapes));
+    for (int t = 0; t < ts.shapeCount; t++) {
+        const BlobTileCollision* tc = &tcs[bts->firstTileCollision + t];
+        TileShapes* shapes = &ts.shapes[t];
+        shapes->tileId = tc->tileId;
+        shapes->polygonCount = tc->polygonCount;
+        shapes->pointCounts = (int*)ArenaAlloc(ts.arena, (tc->polygonCount > 0 ? tc->polygonCount : 1) * sizeof(int));
+        int pointCount = 0;
+        for (int p = 0; p < tc->polygonCount; p++) {
+            shapes->pointCounts[p] = tilePolys[tc->firstPolygon + p].pointCount;
+            pointCount += shapes->pointCounts[p];
+        }
+        shapes->points = (Vector2*)ArenaAlloc(ts.arena, (pointCount > 0 ? (size_t)pointCount : 1) * sizeof(Vector2));
+        Vector2* points = shapes->points;
+        for (int p = 0; p < tc->polygonCount; p++) {
+            Polygon mapped = BlobToPolygon(base, &tilePolys[tc->firstPolygon + p]);
+            if (mapped.pointCount > 0)
+                memcpy(points, mapped.points, mapped.pointCount * sizeof(Vector2));
+            points += mapped.pointCount;
+        }
+    }
+    ts.animationCount = bts->tileAnimationCount;
+    ts.animations = (TileAnimation*)ArenaAllocZero(ts.arena, (ts.animationCount > 0 ? ts.animationCount : 1) * sizeof(TileAnimation));
+    for (int a = 0; a < ts.animationCount; a++) {
+        const BlobTileAnimation* ba = &animations[bts->firstTileAnimation + a];
+        TileAnimation* animation = &ts.animations[a];
+        animation->tileId = ba->tileId;
+        animation->frameCount = ba->frameCount;
+        animation->frames = (TileFrame*)ArenaAlloc(ts.arena, ba->frameCount * sizeof(TileFrame));
+        memcpy(animation->frames, &frames[ba->firstFrame], ba->frameCount * sizeof(TileFrame));
+    }
+    return ts;
+}
+
+// header and every offset checked before anything is dereferenced
+static int ValidateBlob(const unsigned char* base, size_t size) {
+    if (size < sizeof(BlobHeader)) return 0;
+    const BlobHeader* h = (const BlobHeader*)base;
+    if (memcmp(h->magic, MAP_BLOB_MAGIC, 4) != 0) return 0;
+    if (h->version != MAP_BLOB_VERSION || h->fileSize != size) return 0;
+    if (!InBounds(size, h->tilesetOffset, (size_t)h->tilesetCount * sizeof(BlobTileset)) ||
+        !InBounds(size, h->layerOffset, (size_t)h->layerCount * sizeof(BlobLayer)) ||
+        !InBounds(size, h->collisionOffset, (size_t)h->collisionCount * sizeof(BlobPolygon)) ||
+        !InBounds(size, h->transitionOffset, (size_t)h->transitionCount * sizeof(BlobTransition)) ||
+        !InBounds(size, h->tileCollisionOffset, (size_t)h->tileCollisionCount * sizeof(BlobTileCollision)) ||
+        !InBounds(size, h->tilePolygonOffset, (size_t)h->tilePolygonCount * sizeof(BlobPolygon)) ||
+        !InBounds(size, h->tileAnimationOffset, (size_t)h->tileAnimationCount * sizeof(BlobTileAnimation)) ||
+        !InBounds(size, h->tileFrameOffset, (size_t)h->tileFrameCount * sizeof(BlobTileFrame)) ||
+        !InBounds(size, h->stringsOffset, 1))
+        return 0;
+    // the string table must end in a terminator so no lookup can run off the end
+    if (base[size - 1] != '\0') return 0;
+    if (!ObjectGridIsValid(base, size, h)) return 0;
+
+    const BlobLayer* layers = (const BlobLayer*)(base + h->layerOffset);
+    for (uint32_t i = 0; i < h->layerCount; i++) {
+        if (layers[i].chunkCount > 0) {
+            if ((layers[i].chunkOffset & 3) != 0 ||
+                !InBounds(size, layers[i].chunkOffset, (size_t)layers[i].chunkCount * sizeof(BlobChunk)))
+                return 0;
+            const BlobChunk* chunks = (const BlobChunk*)(base + layers[i].chunkOffset);
+            for (uint32_t c = 0; c < layers[i].chunkCount; c++) {
+                size_t count = (size_t)chunks[c].width * chunks[c].height;
+                if (chunks[c].width < 0 || chunks[c].height < 0 || (chunks[c].tilesOffset & 1) != 0 ||
+                    (chunks[c].tilesOffset && !InBounds(size, chunks[c].tilesOffset, count * sizeof(TileId))) ||
+                    (chunks[c].flipsOffset && !InBounds(size, chunks[c].flipsOffset, count)))
+                    return 0;
+            }
+            continue;
+        }
+        if (layers[i].width < 0 || layers[i].height < 0 || (layers[i].tilesOffset & 1) != 0 ||
+            !InBounds(size, layers[i].tilesOffset, (size_t)layers[i].tileCount * sizeof(TileId)) ||
+            (layers[i].flipsOffset && !InBounds(size, layers[i].flipsOffset, layers[i].tileCount)))
+            return 0;
+        if (!layers[i].rowRunsOffset) {
+            if (layers[i].tileCount != (size_t)layers[i].width * layers[i].height) return 0;
+            continue;
+        }
+        if (!SparseLayerIsValid(base, size, &layers[i])) return 0;
+    }
+    const BlobPolygon* polys = (const BlobPolygon*)(base + h->collisionOffset);
+    for (uint32_t i = 0; i < h->collisionCount; i++)
+        if (!PolygonInBounds(size, &polys[i])) return 0;
+    const BlobTransition* trs = (const BlobTransition*)(base + h->transitionOffset);
+    for (uint32_t i = 0; i < h->transitionCount; i++) {
+        if (!PolygonInBounds(size, &trs[i].trigger)) return 0;
+        if (trs[i].targetString >= size - h->stringsOffset) return 0;
+    }
+    const BlobPolygon* tilePolys = (const BlobPolygon*)(base + h->tilePolygonOffset);
+    for (uint32_t i = 0; i < h->tilePolygonCount; i++)
+        if (!PolygonInBounds(size, &tilePolys[i])) return 0;
+    const BlobTileCollision* tcs = (const BlobTileCollision*)(base + h->tileCollisionOffset);
+    for (uint32_t i = 0; i < h->tileCollisionCount; i++) {
+        if (tcs[i].polygonCount < 0 || tcs[i].firstPolygon > h->tilePolygonCount ||
+            (uint32_t)tcs[i].polygonCount > h->tilePolygonCount - tcs[i].firstPolygon)
+            return 0;
+    }
+    const BlobTileAnimation* animations = (const BlobTileAnimation*)(base + h->tileAnimationOffset);
+    for (uint32_t i = 0; i < h->tileAnimationCount; i++) {
+        if (animations[i].frameCount <= 0 || animations[i].firstFrame > h->tileFrameCount ||
+            (uint32_t)animations[i].frameCount > h->tileFrameCount - animations[i].firstFrame)
+            return 0;
+    }
+    const BlobTileFrame* frames = (const BlobTileFrame*)(base + h->tileFrameOffset);
+    const BlobTileset* tss = (const BlobTileset*)(base + h->tilesetOffset);
+    for (uint32_t i = 0; i < h->tilesetCount; i++) {
+        if (tss[i].tileCount < 0 || tss[i].firstTileCollision > h->tileCollisionCount ||
+            tss[i].tileCollisionCount > h->tileCollisionCount - tss[i].firstTileCollision ||
+            tss[i].firstTileAnimation > h->tileAnimationCount ||
+            tss[i].tileAnimationCount > h->tileAnimationCount - tss[i].firstTileAnimation)
+            return 0;
+        // AnimateMapTiles trusts every frame, same checks as LoadTileset
+        const BlobTileAnimation* ownAnimations = &animations[tss[i].firstTileAnimation];
+        for (uint32_t a = 0; a < tss[i].tileAnimationCount; a++) {
+            if (ownAnimations[a].tileId < 0 || ownAnimations[a].tileId >= tss[i].tileCount) return 0;
+            if (a > 0 && ownAnimations[a].tileId <= ownAnimations[a - 1].tileId) return 0;
+            const BlobTileFrame* own = &frames[ownAnimations[a].firstFrame];
+            for (int32_t f = 0; f < ownAnimations[a].frameCount; f++) {
+                if (own[f].tileId < 0 || own[f].tileId >= tss[i].tileCount || own[f].duration <= 0) return 0;
+            }
+        }
+        // GetTileCollision binary searches them
+        const BlobTileCollision* own = &tcs[tss[i].firstTileCollision];
+        for (uint32_t t = 0; t < tss[i].tileCollisionCount; t++) {
+            if (own[t].tileId < 0 || own[t].tileId >= tss[i].tileCount) return 0;
+            if (t > 0 && own[t].tileId <= own[t - 1].tileId) return 0;
+        }
+        if (tss[i].sourceString >= size - h->stringsOffset || tss[i].imageString >= size - h->stringsOffset)
+            return 0;
+    }
+    return 1;
+}
+
+// blob is stale if the .tmj, any tileset or a tileset image changed since it was compiled
+static int BlobIsCurrent(const unsigned char* base, const char* sourcePath) {
+    const BlobHeader* h = (const BlobHeader*)base;
+    if (h->sourceModTime != GetSourceModTime(sourcePath)) return 0;
+    const BlobTileset* tss = (const BlobTileset*)(base + h->tilesetOffset);
+    const char* strings = (const char*)base + h->stringsOffset;
+    for (uint32_t i = 0; i < h->tilesetCount; i++) {
+        if (tss[i].sourceModTime != GetSourceModTime(strings + tss[i].sourceString))
+            return 0;
+        if (tss[i].imageString && tss[i].imageModTime != GetSourceModTime(strings + tss[i].imageString))
+            return 0;
+    }
+    return 1;
+}
+
+int LoadMapBinary(const char* path, const char* sourcePath, GameMap* map) {
+    if (!HostIsLittleEndian()) return 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return 0;
+    }
+    size_t size = (size_t)st.st_size;
+    void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return 0;
+
+    const unsigned char* base = (const unsigned char*)mapped;
+    if (!ValidateBlob(base, size)) {
+        TraceLog(LOG_WARNING, "Compiled map %s is invalid or from another version", path);
+        munmap(mapped, size);
+        return 0;
+    }
+    if (!BlobIsCurrent(base, sourcePath)) {
+        TraceLog(LOG_WARNING, "Compiled map %s is older than its sources, run make maps", path);
+        munmap(mapped, size);
+        return 0;
+    }
+
+    const BlobHeader* h = (const BlobHeader*)base;
+    const char* strings = (const char*)base + h->stringsOffset;
+    GameMap m = {0};
+    m.blob = mapped;
+    m.blobSize = size;
+    m.mapWidth = h->mapWidth;
+    m.mapHeight = h->mapHeight;
+    m.tileWidth = h->tileWidth;
+    m.tileHeight = h->tileHeight;
+
+    // Only the small header arrays are allocated (in the map arena), the bulk data (tiles,
+    // points, strings) stays in the mapping. Tilesets are the exception:
+    // they go to the registry and outlive the blob, so they get copied
+    const BlobTileset* tss = (const BlobTileset*)(base + h->tilesetOffset);
+    m.tilesetCount = h->tilesetCount;
+    m.arena = CreateArena(MAP_ARENA_BLOCK);
+    m.tilesets = (Tileset*)ArenaAllocZero(m.arena, (h->tilesetCount ? h->tilesetCount : 1) * sizeof(Tileset));
+    for (uint32_t i = 0; i < h->tilesetCount; i++) {
+        const char* source = strings + tss[i].sourceString;
+        if (!AcquireSharedTileset(source, tss[i].firstgid, &m.tilesets[i]))
+            m.tilesets[i] = ShareTileset(CopyBlobTileset(base, &tss[i]), tss[i].firstgid);
+    }
+
+    const BlobLayer* layers = (const BlobLayer*)(base + h->layerOffset);
+    m.tileLayerCount = h->layerCount;
+    m.tileLayers = (TileLayer*)ArenaAllocZero(m.arena, (h->layerCount ? h->layerCount : 1) * sizeof(TileLayer));
+    for (uint32_t i = 0; i < h->layerCount; i++) {
+        TileLayer* layer = &m.tileLayers[i];
+        layer->width = layers[i].width;
+        layer->height = layers[i].height;
+        layer->originX = layers[i].originX;
+        layer->originY = layers[i].originY;
+        if (layers[i].chunkCount == 0) {
+            layer->tiles = (TileId*)(base + layers[i].tilesOffset);
+            layer->flips = layers[i].flipsOffset ? (unsigned char*)(base + layers[i].flipsOffset) : NULL;
+            layer->tileCount = (int)layers[i].tileCount;
+            if (layers[i].rowRunsOffset) {
+                layer->runs = (TileRun*)(base + layers[i].runsOffset);
+                layer->rowRuns = (unsigned int*)(base + layers[i].rowRunsOffset);
+            }
+            continue;
+        }
+        // chunks are already decoded, "loading" one only points it at the mapping
+        const BlobChunk* chunks = (const BlobChunk*)(base + layers[i].chunkOffset);
+        layer->chunks = (TileChunk*)ArenaAllocZero(m.arena, layers[i].chunkCount * sizeof(TileChunk));
+        for (uint32_t c = 0; c < layers[i].chunkCount; c++) {
+            if (!chunks[c].tilesOffset) continue;
+            TileChunk* chunk = &layer->chunks[layer->chunkCount++];
+            chunk->x = chunks[c].x;
+            chunk->y = chunks[c].y;
+            chunk->width = chunks[c].width;
+            chunk->height = chunks[c].height;
+            chunk->encoding = TILE_CHUNK_RAW;
+            chunk->source = (const char*)(base + chunks[c].tilesOffset);
+            chunk->sourceLength = chunk->width * chunk->height * (int)sizeof(TileId);
+            chunk->sourceFlips = chunks[c].flipsOffset ? base + chunks[c].flipsOffset : NULL;
+        }
+        BuildChunkGrid(m.arena, layer);
+        m.infinite = 1;
+        m.chunkBudget = CHUNK_MEMORY_BUDGET;
+    }
+
+    const BlobPolygon* polys = (const BlobPolygon*)(base + h->collisionOffset);
+    m.collisionLayer.count = h->collisionCount;
+    m.collisionLayer.polygons = (Polygon*)ArenaAlloc(m.arena, (h->collisionCount ? h->collisionCount : 1) * sizeof(Polygon));
+    for (uint32_t i = 0; i < h->collisionCount; i++)
+        m.collisionLayer.polygons[i] = BlobToPolygon(base, &polys[i]);
+
+    const BlobTransition* trs = (const BlobTransition*)(base + h->transitionOffset);
+    m.transitionCount = h->transitionCount;
+    m.transitions = (MapTransition*)ArenaAlloc(m.arena, (h->transitionCount ? h->transitionCount : 1) * sizeof(MapTransition));
+    for (uint32_t i = 0; i < h->transitionCount; i++) {
+        m.transitions[i].targetMap = (char*)strings + trs[i].targetString;
+        m.transitions[i].startX = trs[i].startX;
+        m.transitions[i].startY = trs[i].startY;
+        m.transitions[i].triggerArea = BlobToPolygon(base, &trs[i].trigger);
+    }
+
+    if (h->tileObjectCount > 0) {
+        m.tileObjects = (TileObject*)(base + h->tileObjectOffset);
+        m.tileObjectCount = (int)h->tileObjectCount;
+        m.objectGrid.bucketSize = h->objectBucketSize;
+        m.objectGrid.x = h->objectGridX;
+        m.objectGrid.y = h->objectGridY;
+        m.objectGrid.width = h->objectGridWidth;
+        m.objectGrid.height = h->objectGridHeight;
+        m.objectGrid.starts = (unsigned int*)(base + h->objectBucketOffset);
+        m.objectGrid.reachX = h->objectReachX;
+        m.objectGrid.reachY = h->objectReachY;
+    }
+
+    *map = m;
+    TraceLog(LOG_INFO, "Mapped compiled map %s (%zu bytes)", path, size);
+    return 1;
+}
+
+void UnloadMapBinary(GameMap* map) {
+    UnloadMapChunks(map);
+    for (int i = 0; i < map->tilesetCount; i++)
+        ReleaseSharedTileset(&map->tilesets[i]);
+    DestroyArena(map->arena);
+    map->arena = NULL;
+    munmap(map->blob, map->blobSize);
+    map->blob = NULL;
+    map->blobSize = 0;
+}
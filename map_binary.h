@@ -0,0 +1,38 @@
+#ifndef MAP_BINARY_H
+#define MAP_BINARY_H
+
+#include "tiled_loader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Compiled map blobs (.tmb) are written by the map compiler (make maps)
+// and memory mapped by LoadGameMap so a map switch skips JSON entirely.
+// Everything in the file is little-endian and 4-byte aligned.
+#define MAP_BLOB_MAGIC "TDMB"
+#define MAP_BLOB_VERSION 9
+
+// "Tiled/Tiledmaps/field.tmj" -> "Tiled/Tiledmaps/field.tmb"
+void GetCompiledMapPath(const char* mapFilePath, char* out, int outSize);
+
+// Writes a map returned by LoadGameMapData (parsed from sourcePath) to path.
+// Chunks of infinite maps are decoded on the way out. Returns 1 on success
+int SaveMapBinary(GameMap* map, const char* sourcePath, const char* path);
+
+// mmaps a compiled map and points the GameMap at it in place.
+// Returns 0 (and leaves map untouched) when the blob is missing, stale
+// (older than sourcePath or one of its tilesets) or from another version.
+int LoadMapBinary(const char* path, const char* sourcePath, GameMap* map);
+
+// frees the header arrays, releases the tilesets and unmaps the blob
+void UnloadMapBinary(GameMap* map);
+
+// modification time of a file in seconds or -1 if it does not exist
+long long GetSourceModTime(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,222 @@
+#include "map_cache.h"
+#include "map_loader.h"
+#include "map_binary.h"
+#include "tileset_registry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAP_CACHE_QUEUE 8
+
+typedef struct {
+    char* path;
+    GameMap* map;            // NULL when loading it failed
+    long long failedModTime; // .tmj mtime of a failed load, it is retried once that changes
+    unsigned int lastUsed;
+} CachedMap;
+
+struct MapCache {
+    MapLoader* loader;
+    CachedMap* entries;
+    int entryCount;
+    int entryCapacity;
+    int capacity;
+    unsigned int clock;
+    char loading[512];       // path the loader is busy with, "" when idle
+    char queue[MAP_CACHE_QUEUE][512];
+    int queueCount;
+    MapCacheStats stats;
+};
+
+MapCache* CreateMapCache(int capacity) {
+    MapCache* cache = (MapCache*)calloc(1, sizeof(MapCache));
+    if (!cache) return NULL;
+    cache->capacity = capacity;
+    cache->loader = CreateMapLoader();
+    return cache;
+}
+
+void DestroyMapCache(MapCache* cache) {
+    if (!cache) return;
+    DestroyMapLoader(cache->loader);
+    for (int i = 0; i < cache->entryCount; i++) {
+        if (cache->entries[i].map) {
+            UnloadGameMap(cache->entries[i].map);
+            free(cache->entries[i].map);
+        }
+        free(cache->entries[i].path);
+    }
+    free(cache->entries);
+    free(cache);
+}
+
+static CachedMap* FindEntry(MapCache* cache, const char* path) {
+    for (int i = 0; i < cache->entryCount; i++) {
+        if (strcmp(cache->entries[i].path, path) == 0)
+            return &cache->entries[i];
+    }
+    return NULL;
+}
+
+static GameMap* InsertMap(MapCache* cache, const char* path, GameMap* map) {
+    if (cache->entryCount >= cache->entryCapacity) {
+        int capacity = cache->entryCapacity ? cache->entryCapacity * 2 : 8;
+        CachedMap* grown = (CachedMap*)realloc(cache->entries, capacity * sizeof(CachedMap));
+        if (!grown) {
+            if (map) {
+                UnloadGameMap(map);
+                free(map);
+            }
+            return NULL;
+        }
+        cache->entries = grown;
+        cache->entryCapacity = capacity;
+    }
+    CachedMap* entry = &cache->entries[cache->entryCount++];
+    entry->path = strdup(path);
+    entry->map = map;
+    entry->failedModTime = map ? 0 : GetSourceModTime(path);
+    entry->lastUsed = ++cache->clock;
+    return map;
+}
+
+GameMap* AddCachedMap(MapCache* cache, const char* mapFilePath, GameMap map) {
+    GameMap* owned = (GameMap*)malloc(sizeof(GameMap));
+    if (!owned) {
+        UnloadGameMap(&map);
+        return NULL;
+    }
+    *owned = map;
+    return InsertMap(cache, mapFilePath, owned);
+}
+
+int IsMapLoading(MapCache* cache, const char* mapFilePath) {
+    if (strcmp(cache->loading, mapFilePath) == 0) return 1;
+    for (int i = 0; i < cache->queueCount; i++) {
+        if (strcmp(cache->queue[i], mapFilePath) == 0) return 1;
+    }
+    return 0;
+}
+
+void PrefetchMap(MapCache* cache, const char* mapFilePath, int urgent) {
+    CachedMap* entry = FindEntry(cache, mapFilePath);
+    if (entry && !entry->map && entry->failedModTime != GetSourceModTime(mapFilePath)) {
+        // the .tmj was edited since it failed, forget the failure
+        free(entry->path);
+        *entry = cache->entries[--cache->entryCount];
+        entry = NULL;
+    }
+    if (entry) return;
+    if (IsMapLoading(cache, mapFilePath)) {
+        if (!urgent) return;
+        // already queued, move it to the front
+        for (int i = 0; i < cache->queueCount; i++) {
+            if (strcmp(cache->queue[i], mapFilePath) != 0) continue;
+            memmove(cache->queue[1], cache->queue[0], i * sizeof(cache->queue[0]));
+            snprintf(cache->queue[0], sizeof(cache->queue[0]), "%s", mapFilePath);
+            break;
+        }
+        return;
+    }
+    if (cache->queueCount == MAP_CACHE_QUEUE) {
+        if (!urgent) return;
+        cache->queueCount--;   // drop the least important prefetch
+    }
+    if (urgent) {
+        memmove(cache->queue[1], cache->queue[0], cache->queueCount * sizeof(cache->queue[0]));
+        snprintf(cache->queue[0], sizeof(cache->queue[0]), "%s", mapFilePath);
+    } else {
+        snprintf(cache->queue[cache->queueCount], sizeof(cache->queue[0]), "%s", mapFilePath);
+    }
+    cache->queueCount++;
+}
+
+GameMap* FindCachedMap(MapCache* cache, const char* mapFilePath) {
+    CachedMap* entry = FindEntry(cache, mapFilePath);
+    if (!entry || !entry->map) return NULL;
+    entry->lastUsed = ++cache->clock;
+    return entry->map;
+}
+
+GameMap* GetCachedMap(MapCache* cache, const char* mapFilePath) {
+    GameMap* map = FindCachedMap(cache, mapFilePath);
+    if (map)
+        cache->stats.hits++;
+    else
+        cache->stats.misses++;
+    return map;
+}
+
+// drops least recently used maps until at most capacity besides current are left
+static void EvictMaps(MapCache* cache, const GameMap* current) {
+    for (;;) {
+        int loaded = 0, oldest = -1;
+        for (int i = 0; i < cache->entryCount; i++) {
+            CachedMap* entry = &cache->entries[i];
+            if (!entry->map || entry->map == current) continue;
+            loaded++;
+            if (oldest < 0 || entry->lastUsed < cache->entries[oldest].lastUsed)
+                oldest = i;
+        }
+        if (loaded <= cache->capacity) break;
+        CachedMap* entry = &cache->entries[oldest];
+        TraceLog(LOG_INFO, "Map cache: evicting %s", entry->path);
+        UnloadGameMap(entry->map);
+        free(entry->map);
+        free(entry->path);
+        cache->entries[oldest] = cache->entries[--cache->entryCount];
+        cache->stats.evictions++;
+    }
+    TrimTilesetRegistry();
+}
+
+void UpdateMapCache(MapCache* cache, const GameMap* current) {
+    if (!cache->loader) {
+        // no loader thread, everything queued loads right here
+        while (cache->queueCount > 0) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s", cache->queue[0]);
+            memmove(cache->queue[0], cache->queue[1], (cache->queueCount - 1) * sizeof(cache->queue[0]));
+            cache->queueCount--;
+            GameMap map = LoadGameMap(path);
+            if (map.mapWidth > 0 || map.infinite) {
+                AddCachedMap(cache, path, map);
+            } else {
+                UnloadGameMap(&map);
+                InsertMap(cache, path, NULL);
+            }
+        }
+        EvictMaps(cache, current);
+        return;
+    }
+    MapLoadState state = UpdateMapLoader(cache->loader);
+    if (state == MAP_LOAD_READY || state == MAP_LOAD_FAILED) {
+        GameMap loaded = TakeLoadedMap(cache->loader);
+        if (state == MAP_LOAD_FAILED) {
+            TraceLog(LOG_WARNING, "Map cache: failed to load %s", cache->loading);
+            UnloadGameMap(&loaded);
+            InsertMap(cache, cache->loading, NULL);
+        } else {
+            AddCachedMap(cache, cache->loading, loaded);
+        }
+        cache->loading[0] = '\0';
+        EvictMaps(cache, current);
+        state = MAP_LOAD_IDLE;
+    }
+    if (state == MAP_LOAD_IDLE && cache->queueCount > 0) {
+        if (RequestMapLoad(cache->loader, cache->queue[0])) {
+            snprintf(cache->loading, sizeof(cache->loading), "%s", cache->queue[0]);
+            memmove(cache->queue[0], cache->queue[1], (cache->queueCount - 1) * sizeof(cache->queue[0]));
+            cache->queueCount--;
+            cache->stats.prefetches++;
+        }
+    }
+}
+
+MapCacheStats GetMapCacheStats(const MapCache* cache) {
+    MapCacheStats stats = cache->stats;
+    stats.resident = 0;
+    for (int i = 0; i < cache->entryCount; i++)
+        stats.resident += cache->entries[i].map != NULL;
+    return stats;
+}
@@ -0,0 +1,55 @@
+#ifndef MAP_CACHE_H
+#define MAP_CACHE_H
+
+#include "tiled_loader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Keeps a few recently used maps resident and loads the targets of nearby
+// MapTransitions in the background (map_loader.h), so crossing a trigger
+// usually just swaps a pointer. The cache owns every map it hands out.
+
+typedef struct MapCache MapCache;
+
+typedef struct {
+    int hits;          // GetCachedMap found the map resident
+    int misses;        // ... and had to wait for a load
+    int prefetches;    // loads started by PrefetchMap
+    int evictions;
+    int resident;      // maps loaded right now
+} MapCacheStats;
+
+// capacity: maps kept resident besides the current one
+MapCache* CreateMapCache(int capacity);
+void DestroyMapCache(MapCache* cache);
+
+// hands an already loaded map to the cache (the first map of the game)
+GameMap* AddCachedMap(MapCache* cache, const char* mapFilePath, GameMap map);
+
+// queues a background load unless the map is resident, queued or failed
+// before (and its .tmj did not change since). urgent requests (the player
+// is already crossing) go to the front
+void PrefetchMap(MapCache* cache, const char* mapFilePath, int urgent);
+
+// resident map or NULL, counted as a hit or a miss
+GameMap* GetCachedMap(MapCache* cache, const char* mapFilePath);
+
+// the same without touching the statistics
+GameMap* FindCachedMap(MapCache* cache, const char* mapFilePath);
+
+// 1 while mapFilePath is queued or loading
+int IsMapLoading(MapCache* cache, const char* mapFilePath);
+
+// Once per frame on the game thread: drives the loader and evicts the least
+// recently used maps past capacity. current is never evicted
+void UpdateMapCache(MapCache* cache, const GameMap* current);
+
+MapCacheStats GetMapCacheStats(const MapCache* cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
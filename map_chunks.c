@@ -0,0 +1,226 @@
+#include "map_chunks.h"
+#include "map_render.h"
+#include "map_collision.h"
+#include "tile_layers.h"
+#include "tiled_json.h"
+#include "tile_data.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int FloorDiv(int a, int b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+void BuildChunkGrid(Arena* arena, TileLayer* layer) {
+    layer->chunkGrid = NULL;
+    layer->gridWidth = layer->gridHeight = 0;
+    if (layer->chunkCount == 0) return;
+
+    layer->chunkWidth = layer->chunks[0].width;
+    layer->chunkHeight = layer->chunks[0].height;
+    if (layer->chunkWidth <= 0 || layer->chunkHeight <= 0) return;
+
+    int minX = 0, minY = 0, maxX = 0, maxY = 0;
+    for (int i = 0; i < layer->chunkCount; i++) {
+        int cx = FloorDiv(layer->chunks[i].x, layer->chunkWidth);
+        int cy = FloorDiv(layer->chunks[i].y, layer->chunkHeight);
+        if (i == 0 || cx < minX) minX = cx;
+        if (i == 0 || cy < minY) minY = cy;
+        if (i == 0 || cx > maxX) maxX = cx;
+        if (i == 0 || cy > maxY) maxY = cy;
+    }
+    layer->gridX = minX;
+    layer->gridY = minY;
+    layer->gridWidth = maxX - minX + 1;
+    layer->gridHeight = maxY - minY + 1;
+    layer->chunkGrid = (int*)ArenaAlloc(arena, layer->gridWidth * layer->gridHeight * sizeof(int));
+    for (int i = 0; i < layer->gridWidth * layer->gridHeight; i++)
+        layer->chunkGrid[i] = -1;
+
+    for (int i = 0; i < layer->chunkCount; i++) {
+        TileChunk* c = &layer->chunks[i];
+        // Tiled writes fixed size chunks on a fixed grid, anything else can't be indexed
+        if (c->width != layer->chunkWidth || c->height != layer->chunkHeight ||
+            c->x % layer->chunkWidth != 0 || c->y % layer->chunkHeight != 0) {
+            TraceLog(LOG_WARNING, "Skipping unaligned %dx%d chunk at (%d, %d)", c->width, c->height, c->x, c->y);
+            continue;
+        }
+        int gx = FloorDiv(c->x, layer->chunkWidth) - minX;
+        int gy = FloorDiv(c->y, layer->chunkHeight) - minY;
+        layer->chunkGrid[gy * layer->gridWidth + gx] = i;
+    }
+}
+
+static int DecodeChunkCSV(TileChunk* chunk, int* tiles, int count) {
+    JsonReader r;
+    JsonInit(&r, chunk->source, chunk->sourceLength);
+    int idx = 0;
+    JsonBeginArray(&r);
+    while (JsonNextElement(&r)) {
+        unsigned int gid = JsonReadUInt(&r);
+        if (idx < count)
+            tiles[idx++] = (int)gid;
+    }
+    for (; idx < count; idx++)
+        tiles[idx] = 0;
+    return !r.error;
+}
+
+int LoadTileChunk(GameMap* map, TileChunk* chunk) {
+    if (chunk->tiles) return 1;
+    int count = chunk->width * chunk->height;
+    if (count <= 0) return 0;
+
+    if (chunk->encoding == TILE_CHUNK_RAW) {
+        // compiled maps: the blob already holds decoded tiles, just point at them
+        chunk->tiles = (TileId*)chunk->source;
+        chunk->flips = (unsigned char*)chunk->sourceFlips;
+    } else {
+        // raw gids are 32 bits, only the converted ids stay resident
+        int* gids = (int*)malloc(count * sizeof(int));
+        TileId* tiles = (TileId*)malloc(count * sizeof(TileId));
+        int ok = gids && tiles && (chunk->encoding == TILE_CHUNK_CSV
+            ? DecodeChunkCSV(chunk, gids, count)
+            : DecodeTileData(chunk->source, chunk->sourceLength, (TileCompression)chunk->compression, gids, count));
+        if (!ok) {
+            TraceLog(LOG_WARNING, "Failed to decode chunk at (%d, %d)", chunk->x, chunk->y);
+            free(gids);
+            free(tiles);
+            return 0;
+        }
+        chunk->flips = TileGidsHaveFlags(gids, count) ? (unsigned char*)malloc(count) : NULL;
+        if (ConvertTileGids(gids, count, tiles, chunk->flips) > 0)
+            TraceLog(LOG_WARNING, "Chunk at (%d, %d) has tile ids past %d, dropped", chunk->x, chunk->y, TILE_NONE - 1);
+        free(gids);
+        chunk->tiles = tiles;
+        map->chunkBytes += count * sizeof(TileId) + (chunk->flips ? count : 0);
+    }
+
+    if (map->residentCount >= map->residentCapacity) {
+        int capacity = map->residentCapacity ? map->residentCapacity * 2 : 32;
+        TileChunk** grown = (TileChunk**)realloc(map->residentChunks, capacity * sizeof(TileChunk*));
+        if (!grown) {
+            UnloadTileChunk(map, chunk);
+            return 0;
+        }
+        map->residentChunks = grown;
+        map->residentCapacity = capacity;
+    }
+    map->residentChunks[map->residentCount++] = chunk;
+    chunk->lastUsed = map->chunkFrame;
+    // bake chunks overlapping it were drawn without these tiles
+    MarkMapTilesDirty(map, chunk->x, chunk->y, chunk->width, chunk->height);
+    return 1;
+}
+
+// frees the decoded data but leaves the resident list alone
+static void ReleaseChunkData(GameMap* map, TileChunk* chunk) {
+    if (chunk->encoding != TILE_CHUNK_RAW) {
+        int count = chunk->width * chunk->height;
+        map->chunkBytes -= count * sizeof(TileId) + (chunk->flips ? count : 0);
+        free(chunk->tiles);
+        free(chunk->flips);
+    }
+    chunk->tiles = NULL;
+    chunk->flips = NULL;
+    FreeChunkCollision(map, chunk);
+}
+
+void UnloadTileChunk(GameMap* map, TileChunk* chunk) {
+    if (!chunk->tiles) return;
+    ReleaseChunkData(map, chunk);
+    for (int i = 0; i < map->residentCount; i++) {
+        if (map->residentChunks[i] == chunk) {
+            map->residentChunks[i] = map->residentChunks[--map->residentCount];
+            break;
+        }
+    }
+}
+
+static int CompareLastUsed(const void* a, const void* b) {
+    unsigned int ua = (*(TileChunk* const*)a)->lastUsed;
+    unsigned int ub = (*(TileChunk* const*)b)->lastUsed;
+    return (ua > ub) - (ua < ub);
+}
+
+void StreamMapChunks(GameMap* map, int tileX, int tileY, int tileWidth, int tileHeight) {
+    if (!map->infinite) return;
+    map->chunkFrame++;
+
+    for (int l = 0; l < map->tileLayerCount; l++) {
+        TileLayer* layer = &map->tileLayers[l];
+        if (!layer->chunkGrid) continue;
+        // one chunk of margin so chunks are decoded before they scroll into view
+        int x0 = FloorDiv(tileX, layer->chunkWidth) - 1 - layer->gridX;
+        int y0 = FloorDiv(tileY, layer->chunkHeight) - 1 - layer->gridY;
+        int x1 = FloorDiv(tileX + tileWidth, layer->chunkWidth) + 1 - layer->gridX;
+        int y1 = FloorDiv(tileY + tileHeight, layer->chunkHeight) + 1 - layer->gridY;
+        if (x0 < 0) x0 = 0;
+        if (y0 < 0) y0 = 0;
+        if (x1 >= layer->gridWidth) x1 = layer->gridWidth - 1;
+        if (y1 >= layer->gridHeight) y1 = layer->gridHeight - 1;
+        for (int gy = y0; gy <= y1; gy++) {
+            for (int gx = x0; gx <= x1; gx++) {
+                int index = layer->chunkGrid[gy * layer->gridWidth + gx];
+                if (index < 0) continue;
+                TileChunk* chunk = &layer->chunks[index];
+                int decoded = !chunk->tiles;
+                if (!LoadTileChunk(map, chunk)) continue;
+                chunk->lastUsed = map->chunkFrame;
+                if (decoded)
+                    BuildChunkCollision(map, chunk);
+            }
+        }
+    }
+
+    if (map->chunkBytes <= map->chunkBudget) return;
+    // evict least recently used first, chunks needed this frame always stay
+    qsort(map->residentChunks, map->residentCount, sizeof(TileChunk*), CompareLastUsed);
+    for (int i = 0; i < map->residentCount && map->chunkBytes > map->chunkBudget; i++) {
+        TileChunk* chunk = map->residentChunks[i];
+        if (chunk->lastUsed == map->chunkFrame) break;
+        // compiled chunks only cost their collision, their tiles stay in the blob
+        if (chunk->encoding != TILE_CHUNK_RAW || chunk->collision)
+            ReleaseChunkData(map, chunk);
+    }
+    int kept = 0;
+    for (int i = 0; i < map->residentCount; i++) {
+        if (map->residentChunks[i]->tiles)
+            map->residentChunks[kept++] = map->residentChunks[i];
+    }
+    map->residentCount = kept;
+}
+
+int GetLayerTile(const TileLayer* layer, int x, int y, unsigned char* flip) {
+    if (flip) *flip = 0;
+    if (layer->tiles) {
+        if (x < 0 || y < 0 || x >= layer->width || y >= layer->height) return -1;
+        int i = y * layer->width + x;
+        if (layer->rowRuns) {
+            unsigned int run = FindTileRun(layer, x, y);
+            if (run == layer->rowRuns[y + 1] || layer->runs[run].x > x) return -1;
+            i = (int)(layer->runs[run].first + (x - layer->runs[run].x));
+        }
+        if (flip && layer->flips) *flip = layer->flips[i];
+        return layer->tiles[i] == TILE_NONE ? -1 : layer->tiles[i];
+    }
+    if (!layer->chunkGrid) return -1;
+    int gx = FloorDiv(x, layer->chunkWidth) - layer->gridX;
+    int gy = FloorDiv(y, layer->chunkHeight) - layer->gridY;
+    if (gx < 0 || gy < 0 || gx >= layer->gridWidth || gy >= layer->gridHeight) return -1;
+    int index = layer->chunkGrid[gy * layer->gridWidth + gx];
+    if (index < 0) return -1;
+    const TileChunk* chunk = &layer->chunks[index];
+    if (!chunk->tiles) return -1;
+    int i = (y - chunk->y) * chunk->width + (x - chunk->x);
+    if (flip && chunk->flips) *flip = chunk->flips[i];
+    return chunk->tiles[i] == TILE_NONE ? -1 : chunk->tiles[i];
+}
+
+void UnloadMapChunks(GameMap* map) {
+    for (int i = 0; i < map->residentCount; i++)
+        ReleaseChunkData(map, map->residentChunks[i]);
+    free(map->residentChunks);
+    map->residentChunks = NULL;
+    map->residentCount = map->residentCapacity = 0;
+}
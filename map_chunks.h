@@ -0,0 +1,38 @@
+#ifndef MAP_CHUNKS_H
+#define MAP_CHUNKS_H
+
+#include "tiled_loader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Infinite Tiled maps keep every layer as chunks. Chunk data stays encoded
+// in the mapped source file and is only decoded while near the camera, so
+// resident memory follows map->chunkBudget instead of the size of the world.
+// Decoded chunks come and go during play so they use malloc, not the arena.
+
+// builds layer->chunkGrid (in the map's arena) once all chunks of a layer are known
+void BuildChunkGrid(Arena* arena, TileLayer* layer);
+
+// Decodes every chunk overlapping the tile rectangle (plus a one chunk
+// margin), with its tile collision, and evicts the least recently used
+// ones beyond map->chunkBudget
+void StreamMapChunks(GameMap* map, int tileX, int tileY, int tileWidth, int tileHeight);
+
+// decodes one chunk, 1 if its tiles are resident afterwards
+int LoadTileChunk(GameMap* map, TileChunk* chunk);
+void UnloadTileChunk(GameMap* map, TileChunk* chunk);
+
+// Tile id at (x, y) in tile coordinates, -1 if empty, outside the layer or
+// in a chunk that is not resident. flip (optional) receives TILE_FLIP_* bits
+int GetLayerTile(const TileLayer* layer, int x, int y, unsigned char* flip);
+
+// frees every decoded chunk (chunk tables and grids go with the map's arena)
+void UnloadMapChunks(GameMap* map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
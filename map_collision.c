@@ -0,0 +1,857 @@
+#include "map_collision.h"
+#include "constants.h"
+#include "tile_data.h"
+#include "tileset_registry.h"
+#include <stdlib.h>
+#include <math.h>
+
+static float Cross(float ax, float ay, float bx, float by, float cx, float cy) {
+    return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+static int OnSegment(const float* xs, const float* ys, int a, int b, int p) {
+    return fminf(xs[a], xs[b]) <= xs[p] && xs[p] <= fmaxf(xs[a], xs[b]) &&
+           fminf(ys[a], ys[b]) <= ys[p] && ys[p] <= fmaxf(ys[a], ys[b]);
+}
+
+// 1 when segment a-b and segment c-d cross or touch
+static int SegmentsMeet(const float* xs, const float* ys, int a, int b, int c, int d) {
+    float o1 = Cross(xs[a], ys[a], xs[b], ys[b], xs[c], ys[c]);
+    float o2 = Cross(xs[a], ys[a], xs[b], ys[b], xs[d], ys[d]);
+    float o3 = Cross(xs[c], ys[c], xs[d], ys[d], xs[a], ys[a]);
+    float o4 = Cross(xs[c], ys[c], xs[d], ys[d], xs[b], ys[b]);
+    if (((o1 > 0.0f && o2 < 0.0f) || (o1 < 0.0f && o2 > 0.0f)) &&
+        ((o3 > 0.0f && o4 < 0.0f) || (o3 < 0.0f && o4 > 0.0f)))
+        return 1;
+    return (o1 == 0.0f && OnSegment(xs, ys, a, b, c)) || (o2 == 0.0f && OnSegment(xs, ys, a, b, d)) ||
+           (o3 == 0.0f && OnSegment(xs, ys, c, d, a)) || (o4 == 0.0f && OnSegment(xs, ys, c, d, b));
+}
+
+// Ear clipping only matches the even-odd rule of CheckShapePoint on simple
+// polygons: no edges meeting besides neighbours at their shared point, and
+// no spike folding back onto the edge before it
+static int IsSimple(const float* xs, const float* ys, const int* ring, int m) {
+    for (int i = 0; i < m; i++) {
+        int a = ring[i], b = ring[(i + 1) % m], c = ring[(i + 2) % m];
+        if (Cross(xs[a], ys[a], xs[b], ys[b], xs[c], ys[c]) == 0.0f &&
+            (xs[b] - xs[a]) * (xs[c] - xs[b]) + (ys[b] - ys[a]) * (ys[c] - ys[b]) < 0.0f)
+            return 0;
+        for (int j = i + 2; j < m; j++) {
+            if (i == 0 && j == m - 1) continue;
+            if (SegmentsMeet(xs, ys, a, b, ring[j], ring[(j + 1) % m]))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+static void AddPiece(CollisionShapes* shapes, int a, int b, int c) {
+    int piece = shapes->pieceCount++;
+    int corners[3] = { a, b, c };
+    for (int k = 0; k < 3; k++) {
+        shapes->cornerX[k][piece] = shapes->xs[corners[k]];
+        shapes->cornerY[k][piece] = shapes->ys[corners[k]];
+    }
+}
+
+// Ear clipping into shapes' pieces, ring is scratch for the polygon's
+// points. Two points make one flat piece. Returns 0 for polygons that are
+// not simple or run out of ears, those keep the edge test
+static int CutPolygon(CollisionShapes* shapes, int index, int* ring) {
+    int first = shapes->starts[index], count = shapes->starts[index + 1] - first;
+    const float* xs = shapes->xs;
+    const float* ys = shapes->ys;
+    // repeated points would make every ear next to them flat
+    int m = 0;
+    for (int i = first; i < first + count; i++) {
+        if (m > 0 && xs[i] == xs[ring[m - 1]] && ys[i] == ys[ring[m - 1]]) continue;
+        ring[m++] = i;
+    }
+    while (m > 1 && xs[ring[m - 1]] == xs[ring[0]] && ys[ring[m - 1]] == ys[ring[0]]) m--;
+    if (m < 3) {
+        AddPiece(shapes, ring[0], ring[m - 1], ring[m - 1]);
+        return 1;
+    }
+    if (!IsSimple(xs, ys, ring, m)) return 0;
+    float area = 0.0f;
+    for (int i = 0, j = m - 1; i < m; j = i++)
+        area += xs[ring[j]] * ys[ring[i]] - xs[ring[i]] * ys[ring[j]];
+    float sign = area >= 0.0f ? 1.0f : -1.0f;
+
+    // the search starts where the last ear was cut, the next one is usually there
+    int start = 0;
+    while (m > 3) {
+        int ear = -1, straight = -1;
+        for (int t = 0; t < m && ear < 0; t++) {
+            int i = (start + t) % m;
+            int p = ring[(i + m - 1) % m], c = ring[i], q = ring[(i + 1) % m];
+            float turn = Cross(xs[p], ys[p], xs[c], ys[c], xs[q], ys[q]) * sign;
+            if (turn == 0.0f && straight < 0 &&
+                (xs[c] - xs[p]) * (xs[q] - xs[c]) + (ys[c] - ys[p]) * (ys[q] - ys[c]) > 0.0f)
+                straight = i;
+            if (turn <= 0.0f) continue;
+            // an ear has no other point inside it or on its edges
+            int clear = 1;
+            for (int k = 0; k < m && clear; k++) {
+                int v = ring[k];
+                if (v == p || v == c || v == q) continue;
+                if ((xs[v] == xs[p] && ys[v] == ys[p]) || (xs[v] == xs[c] && ys[v] == ys[c]) ||
+                    (xs[v] == xs[q] && ys[v] == ys[q]))
+                    continue;
+                clear = !(Cross(xs[p], ys[p], xs[c], ys[c], xs[v], ys[v]) * sign >= 0.0f &&
+                          Cross(xs[c], ys[c], xs[q], ys[q], xs[v], ys[v]) * sign >= 0.0f &&
+                          Cross(xs[q], ys[q], xs[p], ys[p], xs[v], ys[v]) * sign >= 0.0f);
+            }
+            if (clear) ear = i;
+        }
+        if (ear >= 0)
+            AddPiece(shapes, ring[(ear + m - 1) % m], ring[ear], ring[(ear + 1) % m]);
+        else if (straight >= 0)
+            ear = straight;   // a point in the middle of an edge adds nothing
+        else
+            return 0;
+        for (int i = ear; i < m - 1; i++) ring[i] = ring[i + 1];
+        m--;
+        start = ear > 0 ? ear - 1 : 0;
+    }
+    AddPiece(shapes, ring[0], ring[1], ring[2]);
+    return 1;
+}
+
+static void BuildPieces(Arena* arena, CollisionShapes* shapes) {
+    int capacity = 0, mostPoints = 0;
+    for (int i = 0; i < shapes->count; i++) {
+        int points = shapes->starts[i + 1] - shapes->starts[i];
+        if (points >= 2) capacity += points > 3 ? points - 2 : 1;
+        if (points > mostPoints) mostPoints = points;
+    }
+    shapes->pieceStarts = (int*)ArenaAllocZero(arena, (shapes->count + 1) * sizeof(int));
+    for (int k = 0; k < 3; k++) {
+        shapes->cornerX[k] = (float*)ArenaAlloc(arena, (capacity > 0 ? capacity : 1) * sizeof(float));
+        shapes->cornerY[k] = (float*)ArenaAlloc(arena, (capacity > 0 ? capacity : 1) * sizeof(float));
+    }
+    int* ring = (int*)malloc((mostPoints > 0 ? mostPoints : 1) * sizeof(int));
+    int ok = shapes->pieceStarts && ring;
+    for (int k = 0; k < 3; k++) ok = ok && shapes->cornerX[k] && shapes->cornerY[k];
+    if (!ok) {
+        // every polygon keeps the edge test
+        TraceLog(LOG_WARNING, "Out of memory for %d collision pieces", capacity);
+        free(ring);
+        shapes->pieceStarts = NULL;
+        shapes->pieceCount = 0;
+        return;
+    }
+    int failed = 0;
+    for (int i = 0; i < shapes->count; i++) {
+        int start = shapes->pieceCount;
+        shapes->pieceStarts[i] = start;
+        if (shapes->starts[i + 1] - shapes->starts[i] < 2) continue;
+        if (!CutPolygon(shapes, i, ring)) {
+            shapes->pieceCount = start;
+            failed++;
+        }
+    }
+    shapes->pieceStarts[shapes->count] = shapes->pieceCount;
+    free(ring);
+    if (failed > 0)
+        TraceLog(LOG_INFO, "%d collision polygons are not simple, they use the slower edge test", failed);
+}
+
+// the polygons are stride bytes apart, so the trigger areas can be read
+// straight out of the MapTransition array
+static CollisionShapes BuildShapes(Arena* arena, const Polygon* polygons, int count, size_t stride) {
+    CollisionShapes shapes = { 0 };
+    if (count <= 0) return shapes;
+    int pointCount = 0;
+    for (int i = 0; i < count; i++) {
+        const Polygon* poly = (const Polygon*)((const char*)polygons + i * stride);
+        pointCount += poly->pointCount;
+    }
+    shapes.xs = (float*)ArenaAlloc(arena, (pointCount > 0 ? pointCount : 1) * sizeof(float));
+    shapes.ys = (float*)ArenaAlloc(arena, (pointCount > 0 ? pointCount : 1) * sizeof(float));
+    shapes.starts = (int*)ArenaAlloc(arena, (count + 1) * sizeof(int));
+    shapes.bounds = (Rectangle*)ArenaAllocZero(arena, count * sizeof(Rectangle));
+    if (!shapes.xs || !shapes.ys || !shapes.starts || !shapes.bounds) {
+        TraceLog(LOG_WARNING, "Out of memory for %d collision polygons, they are ignored", count);
+        return (CollisionShapes){ 0 };
+    }
+
+    int at = 0;
+    for (int i = 0; i < count; i++) {
+        const Polygon* poly = (const Polygon*)((const char*)polygons + i * stride);
+        shapes.starts[i] = at;
+        if (poly->pointCount <= 0) continue;
+        float minX = poly->points[0].x, maxX = minX, minY = poly->points[0].y, maxY = minY;
+        for (int j = 0; j < poly->pointCount; j++) {
+            minX = fminf(minX, poly->points[j].x);
+            maxX = fmaxf(maxX, poly->points[j].x);
+            minY = fminf(minY, poly->points[j].y);
+            maxY = fmaxf(maxY, poly->points[j].y);
+            shapes.xs[at] = poly->points[j].x * PIXEL_SCALE;
+            shapes.ys[at] = poly->points[j].y * PIXEL_SCALE;
+            at++;
+        }
+        shapes.bounds[i] = (Rectangle){ minX * PIXEL_SCALE, minY * PIXEL_SCALE,
+                                        (maxX - minX) * PIXEL_SCALE, (maxY - minY) * PIXEL_SCALE };
+    }
+    shapes.starts[count] = at;
+    shapes.count = count;
+    BuildPieces(arena, &shapes);
+    return shapes;
+}
+
+static Rectangle MergeBounds(Rectangle a, Rectangle b) {
+    float minX = fminf(a.x, b.x), minY = fminf(a.y, b.y);
+    float maxX = fmaxf(a.x + a.width, b.x + b.width), maxY = fmaxf(a.y + a.height, b.y + b.height);
+    return (Rectangle){ minX, minY, maxX - minX, maxY - minY };
+}
+
+static float CenterOn(const CollisionShapes* shapes, int shape, int axis) {
+    Rectangle box = shapes->bounds[shape];
+    return axis == 0 ? box.x + box.width * 0.5f : box.y + box.height * 0.5f;
+}
+
+// quickselect: order[k] ends up with the k-th centre on axis, smaller ones before it
+static void SelectMedian(const CollisionShapes* shapes, int* order, int axis, int low, int high, int k) {
+    while (low < high) {
+        float pivot = CenterOn(shapes, order[low + (high - low) / 2], axis);
+        int i = low, j = high;
+        while (i <= j) {
+            while (CenterOn(shapes, order[i], axis) < pivot) i++;
+            while (CenterOn(shapes, order[j], axis) > pivot) j--;
+            if (i <= j) {
+                int swap = order[i];
+                order[i++] = order[j];
+                order[j--] = swap;
+            }
+        }
+        if (k <= j)
+            high = j;
+        else if (k >= i)
+            low = i;
+        else
+            break;
+    }
+}
+
+// builds the subtree over order[first, first + count), depth first so a
+// node's left child is the node right after it. Halving every level keeps
+// it within the 64 entry ShapeQuery stack
+static int BuildNodes(CollisionShapes* shapes, int first, int count) {
+    int index = shapes->nodeCount++;
+    Rectangle bounds = shapes->bounds[shapes->order[first]];
+    float minX = CenterOn(shapes, shapes->order[first], 0), maxX = minX;
+    float minY = CenterOn(shapes, shapes->order[first], 1), maxY = minY;
+    for (int i = first + 1; i < first + count; i++) {
+        int shape = shapes->order[i];
+        bounds = MergeBounds(bounds, shapes->bounds[shape]);
+        minX = fminf(minX, CenterOn(shapes, shape, 0));
+        maxX = fmaxf(maxX, CenterOn(shapes, shape, 0));
+        minY = fminf(minY, CenterOn(shapes, shape, 1));
+        maxY = fmaxf(maxY, CenterOn(shapes, shape, 1));
+    }
+    shapes->nodes[index].bounds = bounds;
+    if (count <= COLLISION_LEAF_SHAPES) {
+        shapes->nodes[index].first = first;
+        shapes->nodes[index].count = count;
+        return index;
+    }
+    // split at the median centre along the axis the centres spread most on
+    int axis = maxX - minX >= maxY - minY ? 0 : 1;
+    int half = count / 2;
+    SelectMedian(shapes, shapes->order, axis, first, first + count - 1, first + half);
+    BuildNodes(shapes, first, half);
+    shapes->nodes[index].first = BuildNodes(shapes, first + half, count - half);
+    shapes->nodes[index].count = 0;
+    return index;
+}
+
+// polygons that can never collide (less than 2 points) are left out
+static void BuildHierarchy(Arena* arena, CollisionShapes* shapes) {
+    int usable = 0;
+    for (int i = 0; i < shapes->count; i++)
+        usable += shapes->starts[i + 1] - shapes->starts[i] >= 2;
+    if (usable == 0) return;
+    shapes->order = (int*)ArenaAlloc(arena, usable * sizeof(int));
+    shapes->nodes = (CollisionNode*)ArenaAlloc(arena, (2 * usable) * sizeof(CollisionNode));
+    if (!shapes->order || !shapes->nodes) {
+        TraceLog(LOG_WARNING, "Out of memory for the collision hierarchy, %d polygons are ignored", usable);
+        shapes->order = NULL;
+        shapes->nodes = NULL;
+        return;
+    }
+    int at = 0;
+    for (int i = 0; i < shapes->count; i++) {
+        if (shapes->starts[i + 1] - shapes->starts[i] >= 2)
+            shapes->order[at++] = i;
+    }
+    shapes->nodeCount = 0;
+    BuildNodes(shapes, 0, usable);
+}
+
+// where the collision shapes of one tile id come from, scaled from tileset
+// pixels to map cells. Kept on the map, infinite maps place tiles again
+// whenever a chunk streams in
+typedef struct PlacedShapes {
+    const Tileset* tileset;           // NULL for ids without shapes
+    int tileId;                       // local id in tileset
+    const TileCollision* collision;   // GetTileCollision, once a layer places the tile
+    float scaleX, scaleY;
+} PlacedShapes;
+
+// every id a layer can hold that has shapes, NULL when no tileset has any.
+// The tileset with the highest firstgid at or below an id owns it
+static PlacedShapes* TileShapeTable(GameMap* map, int* size) {
+    *size = 0;
+    for (int i = 0; i < map->tilesetCount; i++) {
+        const Tileset* ts = &map->tilesets[i];
+        if (ts->firstgid < 1 || ts->shapeCount <= 0) continue;
+        int end = ts->firstgid - 1 + ts->shapes[ts->shapeCount - 1].tileId + 1;
+        if (end > *size) *size = end < (int)TILE_NONE ? end : (int)TILE_NONE;
+    }
+    if (*size == 0) return NULL;
+    PlacedShapes* table = (PlacedShapes*)ArenaAllocZero(map->arena, *size * sizeof(PlacedShapes));
+    if (!table) {
+        *size = 0;
+        return NULL;
+    }
+    for (int i = 0; i < map->tilesetCount; i++) {
+        const Tileset* ts = &map->tilesets[i];
+        if (ts->firstgid < 1 || ts->tileWidth <= 0 || ts->tileHeight <= 0) continue;
+        for (int j = 0; j < ts->shapeCount; j++) {
+            int tile = ts->firstgid - 1 + ts->shapes[j].tileId;
+            if (ts->shapes[j].tileId < 0 || tile >= *size) continue;
+            if (table[tile].tileset && table[tile].tileset->firstgid > ts->firstgid) continue;
+            table[tile].tileset = ts;
+            table[tile].tileId = ts->shapes[j].tileId;
+            table[tile].scaleX = (float)map->tileWidth / ts->tileWidth;
+            table[tile].scaleY = (float)map->tileHeight / ts->tileHeight;
+        }
+    }
+    return table;
+}
+
+// the polygons of placed tiles, points back to back in polygon order. The
+// polygons get their points pointer once everything is placed, the points
+// array still moves while it grows
+typedef struct {
+    Polygon* polygons;
+    int count, capacity;
+    Vector2* points;
+    int pointCount, pointCapacity;
+    int failed;
+} PlacedPolygons;
+
+static int GrowPlaced(PlacedPolygons* placed, int points) {
+    if (placed->count >= placed->capacity) {
+        int capacity = placed->capacity ? placed->capacity * 2 : 64;
+        Polygon* grown = (Polygon*)realloc(placed->polygons, capacity * sizeof(Polygon));
+        if (!grown) return 0;
+        placed->polygons = grown;
+        placed->capacity = capacity;
+    }
+    if (placed->pointCount + points > placed->pointCapacity) {
+        int capacity = placed->pointCapacity ? placed->pointCapacity * 2 : 256;
+        while (capacity < placed->pointCount + points) capacity *= 2;
+        Vector2* grown = (Vector2*)realloc(placed->points, capacity * sizeof(Vector2));
+        if (!grown) return 0;
+        placed->points = grown;
+        placed->pointCapacity = capacity;
+    }
+    return 1;
+}
+
+// Adds the polygons of the tile at cell x, y. Tiled flips a tile diagonally
+// first, then horizontally, then vertically
+static void PlaceTileShapes(const GameMap* map, PlacedShapes* shapes, int x, int y, unsigned char flip,
+                            PlacedPolygons* placed) {
+    if (!shapes->collision)
+        shapes->collision = GetTileCollision(shapes->tileset, shapes->tileId);
+    const TileCollision* collision = shapes->collision;
+    if (!collision) return;
+    float w = (float)map->tileWidth, h = (float)map->tileHeight;
+    for (int i = 0; i < collision->polygonCount; i++) {
+        const Polygon* poly = &collision->polygons[i];
+        if (poly->pointCount <= 0) continue;
+        if (!GrowPlaced(placed, poly->pointCount)) {
+            placed->failed = 1;
+            return;
+        }
+        Vector2* out = placed->points + placed->pointCount;
+        for (int j = 0; j < poly->pointCount; j++) {
+            float px = poly->points[j].x * shapes->scaleX, py = poly->points[j].y * shapes->scaleY;
+            if (flip & TILE_FLIP_DIAGONAL) {
+                float swap = px;
+                px = py;
+                py = swap;
+            }
+            if (flip & TILE_FLIP_HORIZONTAL) px = w - px;
+            if (flip & TILE_FLIP_VERTICAL) py = h - py;
+            out[j] = (Vector2){ x * w + px, y * h + py };
+        }
+        placed->polygons[placed->count++] = (Polygon){ NULL, poly->pointCount };
+        placed->pointCount += poly->pointCount;
+    }
+}
+
+// a dense block of tiles whose top-left cell is originX, originY
+static void PlaceBlockShapes(const GameMap* map, PlacedShapes* table, int tableSize, const TileId* tiles,
+                             const unsigned char* flips, int width, int height, int originX, int originY,
+                             PlacedPolygons* placed) {
+    for (int y = 0; y < height && !placed->failed; y++) {
+        for (int x = 0; x < width; x++) {
+            unsigned int tile = tiles[y * width + x];
+            if (tile >= (unsigned int)tableSize || !table[tile].tileset) continue;
+            PlaceTileShapes(map, &table[tile], originX + x, originY + y, flips ? flips[y * width + x] : 0, placed);
+        }
+    }
+}
+
+// walks every placed tile with shapes in the finite layers, chunks get
+// theirs when they stream in (BuildChunkCollision)
+static void PlaceLayerShapes(const GameMap* map, PlacedShapes* table, int tableSize, PlacedPolygons* placed) {
+    for (int l = 0; l < map->tileLayerCount && !placed->failed; l++) {
+        const TileLayer* layer = &map->tileLayers[l];
+        if (!layer->tiles) continue;
+        if (!layer->rowRuns) {
+            PlaceBlockShapes(map, table, tableSize, layer->tiles, layer->flips, layer->width, layer->height,
+                             0, 0, placed);
+            continue;
+        }
+        // sparse rows, every run is a block one row high
+        for (int y = 0; y < layer->height; y++) {
+            for (unsigned int r = layer->rowRuns[y]; r < layer->rowRuns[y + 1]; r++) {
+                const TileRun* run = &layer->runs[r];
+                PlaceBlockShapes(map, table, tableSize, layer->tiles + run->first,
+                                 layer->flips ? layer->flips + run->first : NULL, run->length, 1, run->x, y, placed);
+            }
+        }
+    }
+}
+
+// polygons (count of them) followed by the placed ones, whose buffers are freed
+static CollisionShapes BuildPlacedShapes(Arena* arena, const Polygon* first, int firstCount, PlacedPolygons* placed) {
+    if (placed->failed)
+        TraceLog(LOG_WARNING, "Out of memory for %d tile collision polygons, they are ignored", placed->count);
+    int count = firstCount + (placed->failed ? 0 : placed->count);
+    Polygon* polygons = count > firstCount ? (Polygon*)malloc(count * sizeof(Polygon)) : NULL;
+    if (count > firstCount && !polygons) {
+        TraceLog(LOG_WARNING, "Out of memory for %d tile collision polygons, they are ignored", placed->count);
+        count = firstCount;
+    }
+    CollisionShapes shapes;
+    if (count == firstCount) {
+        shapes = BuildShapes(arena, first, firstCount, sizeof(Polygon));
+    } else {
+        for (int i = 0; i < firstCount; i++)
+            polygons[i] = first[i];
+        Vector2* points = placed->points;
+        for (int i = 0; i < placed->count; i++) {
+            polygons[firstCount + i] = (Polygon){ points, placed->polygons[i].pointCount };
+            points += placed->polygons[i].pointCount;
+        }
+        shapes = BuildShapes(arena, polygons, count, sizeof(Polygon));
+    }
+    free(polygons);
+    free(placed->polygons);
+    free(placed->points);
+    return shapes;
+}
+
+// the Collision layer followed by the shapes of every placed tile
+static CollisionShapes BuildSolidShapes(GameMap* map) {
+    PlacedPolygons placed = { 0 };
+    if (map->tileShapes)
+        PlaceLayerShapes(map, map->tileShapes, map->tileShapeCount, &placed);
+    return BuildPlacedShapes(map->arena, map->collisionLayer.polygons, map->collisionLayer.count, &placed);
+}
+
+static void SetCell(uint64_t* bits, const CollisionGrid* grid, int x, int y) {
+    bits[(size_t)y * grid->rowWords + (x >> 6)] |= (uint64_t)1 << (x & 63);
+}
+
+// every cell holding a point of the segment, a little too many rather than
+// one too few. Coordinates are relative to the grid's first cell
+static void MarkSegment(CollisionGrid* grid, float x1, float y1, float x2, float y2) {
+    float size = grid->cellSize, pad = size * 1e-3f;
+    int row0 = (int)floorf((fminf(y1, y2) - pad) / size), row1 = (int)floorf((fmaxf(y1, y2) + pad) / size);
+    if (row0 < 0) row0 = 0;
+    if (row1 >= grid->height) row1 = grid->height - 1;
+    for (int row = row0; row <= row1; row++) {
+        // x range of the part of the segment within this row
+        float low = fmaxf(row * size, fminf(y1, y2)), high = fminf((row + 1) * size, fmaxf(y1, y2));
+        float xa = x1, xb = x2;
+        if (y1 != y2) {
+            xa = x1 + (x2 - x1) * (low - y1) / (y2 - y1);
+            xb = x1 + (x2 - x1) * (high - y1) / (y2 - y1);
+        }
+        int col0 = (int)floorf((fminf(xa, xb) - pad) / size), col1 = (int)floorf((fmaxf(xa, xb) + pad) / size);
+        if (col0 < 0) col0 = 0;
+        if (col1 >= grid->width) col1 = grid->width - 1;
+        for (int col = col0; col <= col1; col++)
+            SetCell(grid->edge, grid, col, row);
+    }
+}
+
+static int CompareFloats(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+// Cells without an edge of any polygon are all inside or all outside each
+// polygon, so their centre decides. Centres are found by scanlines with the
+// crossing rule of CheckShapePoint
+static void FillShape(CollisionGrid* grid, const CollisionShapes* shapes, int index, float* crossings) {
+    int first = shapes->starts[index], count = shapes->starts[index + 1] - first;
+    if (count < 3) return;
+    const float* xs = shapes->xs + first;
+    const float* ys = shapes->ys + first;
+    float size = grid->cellSize, originX = grid->x * size, originY = grid->y * size;
+    Rectangle box = shapes->bounds[index];
+    int row0 = (int)floorf((box.y - originY) / size), row1 = (int)floorf((box.y + box.height - originY) / size);
+    if (row0 < 0) row0 = 0;
+    if (row1 >= grid->height) row1 = grid->height - 1;
+    for (int row = row0; row <= row1; row++) {
+        float y = originY + (row + 0.5f) * size;
+        int found = 0;
+        for (int i = 0, j = count - 1; i < count; j = i++) {
+            if ((ys[i] > y) != (ys[j] > y))
+                crossings[found++] = (xs[j] - xs[i]) * (y - ys[i]) / (ys[j] - ys[i]) + xs[i];
+        }
+        qsort(crossings, found, sizeof(float), CompareFloats);
+        const uint64_t* edge = grid->edge + (size_t)row * grid->rowWords;
+        for (int k = 0; k + 1 < found; k += 2) {
+            // centres in [crossings[k], crossings[k + 1]) are inside
+            int col0 = (int)ceilf((crossings[k] - originX) / size - 0.5f);
+            int col1 = (int)ceilf((crossings[k + 1] - originX) / size - 0.5f) - 1;
+            if (col0 < 0) col0 = 0;
+            if (col1 >= grid->width) col1 = grid->width - 1;
+            for (int col = col0; col <= col1; col++) {
+                if (!(edge[col >> 6] >> (col & 63) & 1))
+                    SetCell(grid->solid, grid, col, row);
+            }
+        }
+    }
+}
+
+// Rasterizes every solid polygon over the box of all of them. Cells start at
+// COLLISION_CELL_PIXELS art pixels and double while there would be more
+// than COLLISION_GRID_MAX_CELLS of them
+static void BuildCollisionGrid(Arena* arena, CollisionGrid* grid, const CollisionShapes* shapes) {
+    *grid = (CollisionGrid){ 0 };
+    if (shapes->nodeCount <= 0) return;
+    Rectangle box = shapes->nodes[0].bounds;
+    float size = (float)(COLLISION_CELL_PIXELS * PIXEL_SCALE);
+    for (;;) {
+        grid->x = (int)floorf(box.x / size);
+        grid->y = (int)floorf(box.y / size);
+        grid->width = (int)floorf((box.x + box.width) / size) - grid->x + 1;
+        grid->height = (int)floorf((box.y + box.height) / size) - grid->y + 1;
+        if ((long long)grid->width * grid->height <= COLLISION_GRID_MAX_CELLS) break;
+        size *= 2;
+    }
+    grid->cellSize = size;
+    grid->rowWords = (grid->width + 63) / 64;
+    size_t words = (size_t)grid->rowWords * grid->height;
+    grid->solid = (uint64_t*)ArenaAllocZero(arena, words * sizeof(uint64_t));
+    grid->edge = (uint64_t*)ArenaAllocZero(arena, words * sizeof(uint64_t));
+    int mostPoints = 0;
+    for (int i = 0; i < shapes->count; i++) {
+        if (shapes->starts[i + 1] - shapes->starts[i] > mostPoints)
+            mostPoints = shapes->starts[i + 1] - shapes->starts[i];
+    }
+    float* crossings = (float*)malloc((mostPoints > 0 ? mostPoints : 1) * sizeof(float));
+    if (!grid->solid || !grid->edge || !crossings) {
+        // without the grid every query goes to the hierarchy
+        TraceLog(LOG_WARNING, "Out of memory for the %dx%d collision grid", grid->width, grid->height);
+        free(crossings);
+        *grid = (CollisionGrid){ 0 };
+        return;
+    }
+
+    float originX = grid->x * size, originY = grid->y * size;
+    for (int i = 0; i < shapes->count; i++) {
+        int first = shapes->starts[i], count = shapes->starts[i + 1] - first;
+        if (count < 2) continue;
+        const float* xs = shapes->xs + first;
+        const float* ys = shapes->ys + first;
+        for (int k = 0, j = count - 1; k < count; j = k++)
+            MarkSegment(grid, xs[j] - originX, ys[j] - originY, xs[k] - originX, ys[k] - originY);
+    }
+    for (int i = 0; i < shapes->count; i++)
+        FillShape(grid, shapes, i, crossings);
+    free(crossings);
+}
+
+void BuildMapCollision(GameMap* map) {
+    map->solidShapes = (CollisionShapes){ 0 };
+    map->triggerShapes = (CollisionShapes){ 0 };
+    map->collisionGrid = (CollisionGrid){ 0 };
+    if (!map->arena) return;
+    map->tileShapes = TileShapeTable(map, &map->tileShapeCount);
+    map->solidShapes = BuildSolidShapes(map);
+    if (map->transitionCount > 0)
+        map->triggerShapes = BuildShapes(map->arena, &map->transitions[0].triggerArea, map->transitionCount,
+                                         sizeof(MapTransition));
+    BuildHierarchy(map->arena, &map->solidShapes);
+    BuildHierarchy(map->arena, &map->triggerShapes);
+    BuildCollisionGrid(map->arena, &map->collisionGrid, &map->solidShapes);
+}
+
+void BuildChunkCollision(GameMap* map, TileChunk* chunk) {
+    if (chunk->collision || !chunk->tiles || !map->tileShapes) return;
+    PlacedPolygons placed = { 0 };
+    PlaceBlockShapes(map, map->tileShapes, map->tileShapeCount, chunk->tiles, chunk->flips,
+                     chunk->width, chunk->height, chunk->x, chunk->y, &placed);
+    if (placed.count == 0 && !placed.failed) return;
+    Arena* arena = CreateArena(CHUNK_COLLISION_ARENA_BLOCK);
+    ChunkCollision* collision = arena ? (ChunkCollision*)ArenaAllocZero(arena, sizeof(ChunkCollision)) : NULL;
+    if (!collision) {
+        TraceLog(LOG_WARNING, "Out of memory for the collision of chunk at (%d, %d)", chunk->x, chunk->y);
+        DestroyArena(arena);
+        free(placed.polygons);
+        free(placed.points);
+        return;
+    }
+    collision->arena = arena;
+    collision->shapes = BuildPlacedShapes(arena, NULL, 0, &placed);
+    BuildHierarchy(arena, &collision->shapes);
+    BuildCollisionGrid(arena, &collision->grid, &collision->shapes);
+    if (collision->shapes.nodeCount <= 0) {
+        DestroyArena(arena);
+        return;
+    }
+    collision->bytes = ArenaBytes(arena);
+    map->chunkBytes += collision->bytes;
+    chunk->collision = collision;
+}
+
+void FreeChunkCollision(GameMap* map, TileChunk* chunk) {
+    if (!chunk->collision) return;
+    map->chunkBytes -= chunk->collision->bytes;
+    DestroyArena(chunk->collision->arena);
+    chunk->collision = NULL;
+}
+
+// boxes that only touch still overlap, like the edge test below
+static int BoundsTouch(Rectangle a, Rectangle b) {
+    return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+           a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+// clips the segment against rec (Liang-Barsky), 1 when any of it is left
+static int SegmentTouchesRec(float x1, float y1, float x2, float y2, Rectangle rec) {
+    float dx = x2 - x1, dy = y2 - y1;
+    float p[4] = { -dx, dx, -dy, dy };
+    float q[4] = { x1 - rec.x, rec.x + rec.width - x1, y1 - rec.y, rec.y + rec.height - y1 };
+    float t0 = 0.0f, t1 = 1.0f;
+    for (int i = 0; i < 4; i++) {
+        if (p[i] == 0.0f) {
+            if (q[i] < 0.0f) return 0;   // parallel and outside
+            continue;
+        }
+        float t = q[i] / p[i];
+        if (p[i] < 0.0f) {
+            if (t > t1) return 0;
+            if (t > t0) t0 = t;
+        } else {
+            if (t < t0) return 0;
+            if (t < t1) t1 = t;
+        }
+    }
+    return 1;
+}
+
+void BeginShapeQuery(ShapeQuery* query, const CollisionShapes* shapes, Rectangle rec) {
+    query->shapes = shapes;
+    query->rec = rec;
+    query->depth = 0;
+    query->next = 0;
+    query->end = 0;
+    if (shapes->nodeCount > 0)
+        query->stack[query->depth++] = 0;
+}
+
+int NextShape(ShapeQuery* query) {
+    const CollisionShapes* shapes = query->shapes;
+    for (;;) {
+        while (query->next < query->end) {
+            int shape = shapes->order[query->next++];
+            if (BoundsTouch(shapes->bounds[shape], query->rec))
+                return shape;
+        }
+        if (query->depth == 0) return -1;
+        int index = query->stack[--query->depth];
+        const CollisionNode* node = &shapes->nodes[index];
+        if (!BoundsTouch(node->bounds, query->rec)) continue;
+        if (node->count > 0) {
+            query->next = node->first;
+            query->end = node->first + node->count;
+        } else {
+            query->stack[query->depth++] = node->first;
+            query->stack[query->depth++] = index + 1;
+        }
+    }
+}
+
+int CheckShapePoint(const CollisionShapes* shapes, int index, Vector2 point) {
+    int first = shapes->starts[index], count = shapes->starts[index + 1] - first;
+    if (count < 3) return 0;
+    const float* xs = shapes->xs + first;
+    const float* ys = shapes->ys + first;
+    // even-odd crossings of a ray going right, as raylib's CheckCollisionPointPoly
+    int inside = 0;
+    for (int i = 0, j = count - 1; i < count; j = i++) {
+        if ((ys[i] > point.y) != (ys[j] > point.y) &&
+            point.x < (xs[j] - xs[i]) * (point.y - ys[i]) / (ys[j] - ys[i]) + xs[i])
+            inside = !inside;
+    }
+    return inside;
+}
+
+static float Min(float a, float b) { return a < b ? a : b; }
+static float Max(float a, float b) { return a > b ? a : b; }
+
+// 1 when the projections of a piece and of the rectangle overlap on the
+// normal of the piece edge p to q, r being the third corner. Projections
+// are taken relative to p so a rectangle corner on p lands exactly on 0
+static int AxisOverlaps(float px, float py, float qx, float qy, float rx, float ry,
+                        float left, float top, float right, float bottom) {
+    float nx = py - qy, ny = qx - px;
+    float corner = nx * (rx - px) + ny * (ry - py);
+    float x0 = nx * (left - px), x1 = nx * (right - px);
+    float y0 = ny * (top - py), y1 = ny * (bottom - py);
+    return (Min(x0, x1) + Min(y0, y1) <= Max(0.0f, corner)) & (Max(x0, x1) + Max(y0, y1) >= Min(0.0f, corner));
+}
+
+// Separating axis test of rec against pieces [first, end): the two axes of
+// rec and the three edge normals of each piece. No branches within a block
+// of 8 pieces, so compilers run it on several pieces at a time
+static int PiecesTouchRec(const CollisionShapes* shapes, int first, int end, Rectangle rec) {
+    const float* ax = shapes->cornerX[0];
+    const float* ay = shapes->cornerY[0];
+    const float* bx = shapes->cornerX[1];
+    const float* by = shapes->cornerY[1];
+    const float* cx = shapes->cornerX[2];
+    const float* cy = shapes->cornerY[2];
+    float left = rec.x, right = rec.x + rec.width, top = rec.y, bottom = rec.y + rec.height;
+    int touch = 0;
+    for (int block = first; block < end && !touch; block += 8) {
+        int stop = block + 8 < end ? block + 8 : end;
+        for (int i = block; i < stop; i++) {
+            int hit = (Min(Min(ax[i], bx[i]), cx[i]) <= right) & (Max(Max(ax[i], bx[i]), cx[i]) >= left) &
+                      (Min(Min(ay[i], by[i]), cy[i]) <= bottom) & (Max(Max(ay[i], by[i]), cy[i]) >= top);
+            hit &= AxisOverlaps(ax[i], ay[i], bx[i], by[i], cx[i], cy[i], left, top, right, bottom);
+            hit &= AxisOverlaps(bx[i], by[i], cx[i], cy[i], ax[i], ay[i], left, top, right, bottom);
+            hit &= AxisOverlaps(cx[i], cy[i], ax[i], ay[i], bx[i], by[i], left, top, right, bottom);
+            touch |= hit;
+        }
+    }
+    return touch;
+}
+
+int CheckShapeRec(const CollisionShapes* shapes, int index, Rectangle rec) {
+    int first = shapes->starts[index], count = shapes->starts[index + 1] - first;
+    if (count < 2 || !BoundsTouch(shapes->bounds[index], rec)) return 0;
+    if (shapes->pieceStarts && shapes->pieceStarts[index] < shapes->pieceStarts[index + 1])
+        return PiecesTouchRec(shapes, shapes->pieceStarts[index], shapes->pieceStarts[index + 1], rec);
+
+    // not cut into pieces, so its edges then whether rec is inside
+    const float* xs = shapes->xs + first;
+    const float* ys = shapes->ys + first;
+    for (int i = 0, j = count - 1; i < count; j = i++) {
+        if (SegmentTouchesRec(xs[j], ys[j], xs[i], ys[i], rec))
+            return 1;
+    }
+    // no edge reaches rec, so it is either all inside or all outside the polygon
+    return CheckShapePoint(shapes, index, (Vector2){ rec.x, rec.y });
+}
+
+int FindSolidShape(const GameMap* map, Rectangle rec) {
+    ShapeQuery query;
+    int shape;
+    for (BeginShapeQuery(&query, &map->solidShapes, rec); (shape = NextShape(&query)) >= 0;) {
+        if (CheckShapeRec(&map->solidShapes, shape, rec))
+            return shape;
+    }
+    return -1;
+}
+
+// 1 solid, 0 free, -1 when rec reaches an edge cell and only the polygons can tell
+static int CheckGridRec(const CollisionGrid* grid, Rectangle rec) {
+    float size = grid->cellSize;
+    int col0 = (int)floorf(rec.x / size) - grid->x, col1 = (int)floorf((rec.x + rec.width) / size) - grid->x;
+    int row0 = (int)floorf(rec.y / size) - grid->y, row1 = (int)floorf((rec.y + rec.height) / size) - grid->y;
+    if (col0 < 0) col0 = 0;
+    if (row0 < 0) row0 = 0;
+    if (col1 >= grid->width) col1 = grid->width - 1;
+    if (row1 >= grid->height) row1 = grid->height - 1;
+    if (col0 > col1 || row0 > row1) return 0;
+
+    int word0 = col0 >> 6, word1 = col1 >> 6;
+    uint64_t firstMask = ~(uint64_t)0 << (col0 & 63);
+    uint64_t lastMask = ~(uint64_t)0 >> (63 - (col1 & 63));
+    uint64_t edge = 0;
+    for (int row = row0; row <= row1; row++) {
+        const uint64_t* solid = grid->solid + (size_t)row * grid->rowWords;
+        const uint64_t* edges = grid->edge + (size_t)row * grid->rowWords;
+        for (int w = word0; w <= word1; w++) {
+            uint64_t mask = ~(uint64_t)0;
+            if (w == word0) mask &= firstMask;
+            if (w == word1) mask &= lastMask;
+            if (solid[w] & mask) return 1;
+            edge |= edges[w] & mask;
+        }
+    }
+    return edge ? -1 : 0;
+}
+
+// the grid answers first, the polygons only where it can not tell
+static int CheckShapesRec(const CollisionGrid* grid, const CollisionShapes* shapes, Rectangle rec) {
+    if (grid->solid) {
+        int cells = CheckGridRec(grid, rec);
+        if (cells >= 0) return cells;
+    }
+    ShapeQuery query;
+    int shape;
+    for (BeginShapeQuery(&query, shapes, rec); (shape = NextShape(&query)) >= 0;) {
+        if (CheckShapeRec(shapes, shape, rec))
+            return 1;
+    }
+    return 0;
+}
+
+// the resident chunks around rec, one chunk of margin for tile shapes that
+// stick out of their tile
+static int CheckChunksRec(const GameMap* map, Rectangle rec) {
+    float tileWidth = map->tileWidth * PIXEL_SCALE, tileHeight = map->tileHeight * PIXEL_SCALE;
+    for (int l = 0; l < map->tileLayerCount; l++) {
+        const TileLayer* layer = &map->tileLayers[l];
+        if (!layer->chunkGrid) continue;
+        float chunkWidth = tileWidth * layer->chunkWidth, chunkHeight = tileHeight * layer->chunkHeight;
+        int x0 = (int)floorf(rec.x / chunkWidth) - 1 - layer->gridX;
+        int y0 = (int)floorf(rec.y / chunkHeight) - 1 - layer->gridY;
+        int x1 = (int)floorf((rec.x + rec.width) / chunkWidth) + 1 - layer->gridX;
+        int y1 = (int)floorf((rec.y + rec.height) / chunkHeight) + 1 - layer->gridY;
+        if (x0 < 0) x0 = 0;
+        if (y0 < 0) y0 = 0;
+        if (x1 >= layer->gridWidth) x1 = layer->gridWidth - 1;
+        if (y1 >= layer->gridHeight) y1 = layer->gridHeight - 1;
+        for (int gy = y0; gy <= y1; gy++) {
+            for (int gx = x0; gx <= x1; gx++) {
+                int index = layer->chunkGrid[gy * layer->gridWidth + gx];
+                if (index < 0) continue;
+                const ChunkCollision* collision = layer->chunks[index].collision;
+                if (collision && BoundsTouch(collision->shapes.nodes[0].bounds, rec) &&
+                    CheckShapesRec(&collision->grid, &collision->shapes, rec))
+                    return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int CheckSolidRec(const GameMap* map, Rectangle rec) {
+    if (CheckShapesRec(&map->collisionGrid, &map->solidShapes, rec)) return 1;
+    return map->infinite && map->tileShapes && CheckChunksRec(map, rec);
+}
@@ -0,0 +1,72 @@
+#ifndef MAP_COLLISION_H
+#define MAP_COLLISION_H
+
+#include "tiled_loader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Collision and trigger polygons are stored in map pixels, but every test
+// happens in world space. They are scaled by PIXEL_SCALE once when the map
+// loads, into flat x and y arrays with a bounding box per polygon, and the
+// queries read those directly: polygons whose box misses the rectangle are
+// skipped without touching their points, and there is no limit on points.
+// A bounding volume hierarchy over the boxes (median splits, at most
+// COLLISION_LEAF_SHAPES polygons per leaf) is built at the same time, so a
+// query only visits the branches around its rectangle and its cost grows
+// with the log of the polygon count.
+// Each polygon is also cut into triangles (ear clipping) at load, and
+// CheckShapeRec runs a separating axis test over all of them in one
+// branch free loop. Polygons that are not simple keep the edge test.
+// The shapes tiles carry in their tileset (Tiled's tile collision editor)
+// become solid polygons too, one copy per placed tile with its flips. On
+// infinite maps each resident chunk carries its own tile polygons and grid
+// (BuildChunkCollision), so collision follows the streamed chunks.
+// All solid polygons are also rasterized into map->collisionGrid, cells of
+// COLLISION_CELL_PIXELS art pixels: CheckSolidRec answers from the bits
+// when rec only reaches empty or fully solid cells, and only cells a
+// polygon edge passes through need the exact test.
+
+// Fills map->solidShapes and map->triggerShapes (in the map's arena),
+// LoadGameMapWithoutTextures does it for every loaded map
+void BuildMapCollision(GameMap* map);
+
+// Tile polygons and grid of a chunk StreamMapChunks just decoded, in an arena
+// of its own counted in map->chunkBytes. Nothing when no tile in it has shapes
+void BuildChunkCollision(GameMap* map, TileChunk* chunk);
+// drops them again when the chunk is evicted
+void FreeChunkCollision(GameMap* map, TileChunk* chunk);
+
+// walks the polygons whose box touches a rectangle, in no particular order
+typedef struct {
+    const CollisionShapes* shapes;
+    Rectangle rec;
+    int stack[64];        // nodes still to visit, the hierarchy is never deeper than that
+    int depth;
+    int next, end;        // rest of the leaf being walked, in shapes->order
+} ShapeQuery;
+
+// for (BeginShapeQuery(&q, shapes, rec); (i = NextShape(&q)) >= 0;) ...
+void BeginShapeQuery(ShapeQuery* query, const CollisionShapes* shapes, Rectangle rec);
+// next polygon index, -1 when there are no more
+int NextShape(ShapeQuery* query);
+
+// 1 when rec overlaps or touches polygon index (closing edge included)
+int CheckShapeRec(const CollisionShapes* shapes, int index, Rectangle rec);
+
+// 1 when point is inside polygon index, polygons need 3 points for that
+int CheckShapePoint(const CollisionShapes* shapes, int index, Vector2 point);
+
+// index in map->solidShapes of a polygon rec overlaps, -1 when there is
+// none. Chunk tile shapes are not in there, CheckSolidRec covers them too
+int FindSolidShape(const GameMap* map, Rectangle rec);
+
+// 1 when rec overlaps any solid polygon, those of the resident chunks included
+int CheckSolidRec(const GameMap* map, Rectangle rec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
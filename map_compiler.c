@@ -0,0 +1,93 @@
+// Offline map compiler: turns Tiled .tmj maps (and their .tsj tilesets)
+// into the binary .tmb blobs LoadGameMap memory maps at runtime. Tiles
+// hidden under fully opaque tiles are dropped on the way (FlattenTileLayers),
+// this is the one place the tileset pixels are at hand for that. Hidden
+// tiles with collision shapes stay, the collision built at load needs them.
+//
+// usage: mapc <map.tmj> [out.tmb]
+//        out defaults to the .tmj path with a .tmb extension
+#include "tiled_loader.h"
+#include "map_binary.h"
+#include "tileset_registry.h"
+#include "tile_layers.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// 1 where every pixel of the tile's cell is fully opaque
+static int CellIsOpaque(const Image* image, int x0, int y0, int width, int height) {
+    if (x0 + width > image->width || y0 + height > image->height) return 0;
+    const unsigned char* pixels = (const unsigned char*)image->data;
+    for (int y = y0; y < y0 + height; y++) {
+        for (int x = x0; x < x0 + width; x++) {
+            if (pixels[(y * image->width + x) * 4 + 3] != 255) return 0;
+        }
+    }
+    return 1;
+}
+
+// opaque[id] for every tile id of the map, NULL when it can not be built.
+// Animated tiles never count, their other frames may have holes
+static unsigned char* ComputeTileOpacity(const GameMap* map, int* count) {
+    *count = 0;
+    for (int i = 0; i < map->tilesetCount; i++) {
+        const Tileset* ts = &map->tilesets[i];
+        if (ts->firstgid - 1 + ts->tileCount > *count)
+            *count = ts->firstgid - 1 + ts->tileCount;
+    }
+    unsigned char* opaque = (unsigned char*)calloc(*count > 0 ? *count : 1, 1);
+    if (!opaque) return NULL;
+    for (int i = 0; i < map->tilesetCount; i++) {
+        const Tileset* ts = &map->tilesets[i];
+        if (!ts->imagePath || ts->firstgid < 1 || ts->tileWidth <= 0 || ts->tileHeight <= 0) continue;
+        Image image = LoadImage(ts->imagePath);
+        if (!image.data) continue;
+        ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        int columns = image.width / ts->tileWidth;
+        for (int local = 0; columns > 0 && local < ts->tileCount; local++) {
+            opaque[ts->firstgid - 1 + local] = (unsigned char)CellIsOpaque(&image,
+                (local % columns) * ts->tileWidth, (local / columns) * ts->tileHeight, ts->tileWidth, ts->tileHeight);
+        }
+        for (int a = 0; a < ts->animationCount; a++)
+            opaque[ts->firstgid - 1 + ts->animations[a].tileId] = 0;
+        UnloadImage(image);
+    }
+    return opaque;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s <map.tmj> [out.tmb]\n", argv[0]);
+        return 1;
+    }
+    SetTraceLogLevel(LOG_WARNING);
+
+    const char* source = argv[1];
+    char outPath[512];
+    if (argc == 3)
+        snprintf(outPath, sizeof(outPath), "%s", argv[2]);
+    else
+        GetCompiledMapPath(source, outPath, sizeof(outPath));
+
+    GameMap map = LoadGameMapData(source);
+    if (map.mapWidth == 0 || map.mapHeight == 0) {
+        fprintf(stderr, "%s: failed to parse map\n", source);
+        return 1;
+    }
+    int opaqueCount = 0;
+    unsigned char* opaque = ComputeTileOpacity(&map, &opaqueCount);
+    if (opaque) {
+        int dropped = FlattenTileLayers(&map, opaque, opaqueCount);
+        if (dropped > 0)
+            printf("%s: %d tiles hidden under opaque tiles dropped\n", source, dropped);
+        free(opaque);
+    }
+    int ok = SaveMapBinary(&map, source, outPath);
+    UnloadGameMap(&map);
+    UnloadTilesetRegistry();
+    if (!ok) {
+        fprintf(stderr, "%s: failed to write %s\n", source, outPath);
+        return 1;
+    }
+    printf("%s -> %s\n", source, outPath);
+    return 0;
+}
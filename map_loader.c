@@ -0,0 +1,133 @@
+#include "map_loader.h"
+#include "tileset_registry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+struct MapLoader {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int quit;
+    MapLoadState state;        // guarded by lock
+    char path[512];
+    GameMap map;
+    Image* images;             // decoded tileset images, one per map tileset
+    int nextUpload;
+};
+
+static void* LoaderThread(void* arg) {
+    MapLoader* loader = (MapLoader*)arg;
+    pthread_mutex_lock(&loader->lock);
+    for (;;) {
+        while (!loader->quit && loader->state != MAP_LOAD_PARSING)
+            pthread_cond_wait(&loader->wake, &loader->lock);
+        if (loader->quit) break;
+        pthread_mutex_unlock(&loader->lock);
+
+        GameMap map = LoadGameMapWithoutTextures(loader->path);
+        // image decoding is the slow part of a texture load and needs no GL,
+        // so it runs on the asset workers and only the upload is left to the
+        // game thread
+        Image* images = DecodeTilesetImages(map.tilesets, map.tilesetCount);
+
+        pthread_mutex_lock(&loader->lock);
+        loader->map = map;
+        loader->images = images;
+        loader->nextUpload = 0;
+        loader->state = (map.mapWidth > 0 || map.infinite) ? MAP_LOAD_UPLOADING : MAP_LOAD_FAILED;
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return NULL;
+}
+
+MapLoader* CreateMapLoader(void) {
+    MapLoader* loader = (MapLoader*)calloc(1, sizeof(MapLoader));
+    if (!loader) return NULL;
+    pthread_mutex_init(&loader->lock, NULL);
+    pthread_cond_init(&loader->wake, NULL);
+    if (pthread_create(&loader->thread, NULL, LoaderThread, loader) != 0) {
+        TraceLog(LOG_ERROR, "Failed to start map loader thread");
+        pthread_mutex_destroy(&loader->lock);
+        pthread_cond_destroy(&loader->wake);
+        free(loader);
+        return NULL;
+    }
+    return loader;
+}
+
+static void FreeImages(MapLoader* loader) {
+    for (int i = loader->nextUpload; loader->images && i < loader->map.tilesetCount; i++) {
+        if (loader->images[i].data)
+            UnloadImage(loader->images[i]);
+    }
+    free(loader->images);
+    loader->images = NULL;
+}
+
+void DestroyMapLoader(MapLoader* loader) {
+    if (!loader) return;
+    pthread_mutex_lock(&loader->lock);
+    loader->quit = 1;
+    pthread_cond_signal(&loader->wake);
+    pthread_mutex_unlock(&loader->lock);
+    pthread_join(loader->thread, NULL);
+
+    FreeImages(loader);
+    UnloadGameMap(&loader->map);
+    pthread_mutex_destroy(&loader->lock);
+    pthread_cond_destroy(&loader->wake);
+    free(loader);
+}
+
+int RequestMapLoad(MapLoader* loader, const char* mapFilePath) {
+    pthread_mutex_lock(&loader->lock);
+    int accepted = loader->state == MAP_LOAD_IDLE;
+    if (accepted) {
+        snprintf(loader->path, sizeof(loader->path), "%s", mapFilePath);
+        loader->state = MAP_LOAD_PARSING;
+        pthread_cond_signal(&loader->wake);
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return accepted;
+}
+
+MapLoadState UpdateMapLoader(MapLoader* loader) {
+    pthread_mutex_lock(&loader->lock);
+    MapLoadState state = loader->state;
+    pthread_mutex_unlock(&loader->lock);
+    if (state != MAP_LOAD_UPLOADING)
+        return state;
+
+    // the thread is done with map and images, no lock needed from here
+    GameMap* map = &loader->map;
+    while (loader->nextUpload < map->tilesetCount) {
+        int i = loader->nextUpload++;
+        if (!loader->images || !loader->images[i].data) continue;
+        UploadSharedTilesetTexture(&map->tilesets[i], loader->images[i]);
+        return MAP_LOAD_UPLOADING;   // one upload per frame
+    }
+    free(loader->images);
+    loader->images = NULL;
+    // every texture is resident now, this only copies the ids into the map
+    LoadGameMapTextures(map);
+
+    pthread_mutex_lock(&loader->lock);
+    loader->state = MAP_LOAD_READY;
+    pthread_mutex_unlock(&loader->lock);
+    return MAP_LOAD_READY;
+}
+
+GameMap TakeLoadedMap(MapLoader* loader) {
+    pthread_mutex_lock(&loader->lock);
+    GameMap map = {0};
+    if (loader->state == MAP_LOAD_READY || loader->state == MAP_LOAD_FAILED) {
+        FreeImages(loader);
+        map = loader->map;
+        memset(&loader->map, 0, sizeof(GameMap));
+        loader->state = MAP_LOAD_IDLE;
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return map;
+}
@@ -0,0 +1,44 @@
+#ifndef MAP_LOADER_H
+#define MAP_LOADER_H
+
+#include "tiled_loader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Loads the next map on a background thread so a transition never stalls
+// the game loop. The thread parses (or maps) the map and decodes the images
+// of tilesets that are not resident yet; the game thread then uploads one
+// texture per UpdateMapLoader call and takes the finished map.
+
+typedef enum {
+    MAP_LOAD_IDLE = 0,
+    MAP_LOAD_PARSING,     // loader thread busy
+    MAP_LOAD_UPLOADING,   // textures going to the GPU, one per frame
+    MAP_LOAD_READY,       // TakeLoadedMap
+    MAP_LOAD_FAILED
+} MapLoadState;
+
+typedef struct MapLoader MapLoader;
+
+// starts the loader thread
+MapLoader* CreateMapLoader(void);
+
+// stops the thread and drops any map still in flight
+void DestroyMapLoader(MapLoader* loader);
+
+// queues mapFilePath, 0 when a load is already in progress
+int RequestMapLoad(MapLoader* loader, const char* mapFilePath);
+
+// game thread, once per frame: uploads at most one texture
+MapLoadState UpdateMapLoader(MapLoader* loader);
+
+// hands over the READY map (or an empty one after FAILED), back to IDLE
+GameMap TakeLoadedMap(MapLoader* loader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,128 +1,91 @@
 #include "map_manager.h"
 #include "constants.h"
+#include "map_chunks.h"
+#include "map_collision.h"
+#include "map_objects.h"
+#include "render_queue.h"
+#include "tileset_registry.h"
 #include "raylib.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 
-static int GetTilesetIndex(GameMap* map, int globalTileID) {
-    int index = -1;
-    for (int i = 0; i < map->tilesetCount; i++) {
-        if (globalTileID >= map->tilesets[i].firstgid)
-            index = i;
-        else
-            break;
-    }
-    return index;
-}
-
-static void RenderLayer(GameMap* map, TileLayer* layer, float scale) {
-    for (int y = 0; y < layer->height; y++) {
-        for (int x = 0; x < layer->width; x++) {
-            int tileIndex = layer->tiles[y * layer->width + x];
-            if (tileIndex < 0) continue;  //skip empty
-
-            int globalTileID = tileIndex + 1;
-            int tsIndex = GetTilesetIndex(map, globalTileID);
-            if (tsIndex < 0) continue;
-
-            Tileset ts = map->tilesets[tsIndex];
-            int localTileID = globalTileID - ts.firstgid;
-            int tsColumns = ts.texture.width / ts.tileWidth;
-
-            Rectangle sourceRec = {
-                (localTileID % tsColumns) * ts.tileWidth,
-                (localTileID / tsColumns) * ts.tileHeight,
-                ts.tileWidth,
-                ts.tileHeight
-            };
-
-            Rectangle destRec = {
-                x * map->tileWidth * scale,
-                y * map->tileHeight * scale,
-                map->tileWidth * scale,
-                map->tileHeight * scale
-            };
-
-            DrawTexturePro(ts.texture, sourceRec, destRec, (Vector2){0, 0}, 0.0f, WHITE);
+// outlines of world space polygons, closing edge included
+static void RenderShapes(const CollisionShapes* shapes, Color color) {
+    for (int i = 0; i < shapes->count; i++) {
+        int first = shapes->starts[i], count = shapes->starts[i + 1] - first;
+        if (count < 2) continue;
+        for (int j = 0; j < count; j++) {
+            int next = first + (j + 1) % count;
+            Vector2 p1 = { shapes->xs[first + j], shapes->ys[first + j] };
+            Vector2 p2 = { shapes->xs[next], shapes->ys[next] };
+            QueueLine(RENDER_LAYER_DEBUG, 0.0f, p1, p2, color);
         }
     }
 }
 
-static void RenderGameMap(GameMap* map, float scale) {
-    for (int i = 0; i < map->tileLayerCount; i++) {
-        RenderLayer(map, &map->tileLayers[i], scale);
-    }
-}
-
-static void RenderCollisionPolygons(GameMap* map, float scale) {
+static void RenderCollisionPolygons(GameMap* map) {
 #if DEBUG_DRAW_COLLISIONS
-    for (int i = 0; i < map->collisionLayer.count; i++) {
-        Polygon poly = map->collisionLayer.polygons[i];
-        if (poly.pointCount < 2) continue;
-        for (int j = 0; j < poly.pointCount; j++) {
-            int next = (j + 1) % poly.pointCount;
-            Vector2 p1 = { poly.points[j].x * scale, poly.points[j].y * scale };
-            Vector2 p2 = { poly.points[next].x * scale, poly.points[next].y * scale };
-            DrawLine((int)p1.x, (int)p1.y, (int)p2.x, (int)p2.y, BLUE);
-        }
+    RenderShapes(&map->solidShapes, BLUE);
+    for (int i = 0; i < map->residentCount; i++) {
+        if (map->residentChunks[i]->collision)
+            RenderShapes(&map->residentChunks[i]->collision->shapes, BLUE);
     }
 #endif
 }
 
-static void RenderMapTransitionPolygons(GameMap* map, float scale) {
+static void RenderMapTransitionPolygons(GameMap* map) {
 #if DEBUG_DRAW_MAPTRANSITIONS
-    for (int i = 0; i < map->transitionCount; i++) {
-        Polygon poly = map->transitions[i].triggerArea;
-        if (poly.pointCount < 2) continue;
-        for (int j = 0; j < poly.pointCount; j++) {
-            int next = (j + 1) % poly.pointCount;
-            Vector2 p1 = { poly.points[j].x * scale, poly.points[j].y * scale };
-            Vector2 p2 = { poly.points[next].x * scale, poly.points[next].y * scale };
-            DrawLine((int)p1.x, (int)p1.y, (int)p2.x, (int)p2.y, RED);
-        }
-    }
+    RenderShapes(&map->triggerShapes, RED);
 #endif
 }
 
-static int CheckMapTransitionCollision(GameMap* map, Rectangle playerRect, float scale, int* transitionIndex) {
-    for (int i = 0; i < map->transitionCount; i++) {
-        Polygon poly = map->transitions[i].triggerArea;
-        if (poly.pointCount < 2) continue;
-        if (poly.pointCount > 128) continue;
-
-        Vector2 worldPoly[128];
-        for (int j = 0; j < poly.pointCount; j++) {
-            worldPoly[j].x = poly.points[j].x * scale;
-            worldPoly[j].y = poly.points[j].y * scale;
-        }
-        
-        // Debug output
-        TraceLog(LOG_DEBUG, "Transition %d: Player at (%.2f, %.2f), checking against polygon:", 
-                i, playerRect.x, playerRect.y);
-        for (int j = 0; j < poly.pointCount; j++) {
-            TraceLog(LOG_DEBUG, "Point %d: (%.2f, %.2f)", j, worldPoly[j].x, worldPoly[j].y);
-        }
-
-        Vector2 corners[4] = {
-            { playerRect.x, playerRect.y },
-            { playerRect.x + playerRect.width, playerRect.y },
-            { playerRect.x + playerRect.width, playerRect.y + playerRect.height },
-            { playerRect.x, playerRect.y + playerRect.height }
-        };
-        
-        for (int c = 0; c < 4; c++) {
-            if (CheckCollisionPointPoly(corners[c], worldPoly, poly.pointCount)) {
-                *transitionIndex = i;
-                TraceLog(LOG_INFO, "Transition triggered at corner %d", c);
-                return 1;
-            }
+static int CheckMapTransitionCollision(GameMap* map, Rectangle playerRect, int* transitionIndex) {
+    const CollisionShapes* shapes = &map->triggerShapes;
+    ShapeQuery query;
+    int i;
+    // only triggers whose box touches the player
+    for (BeginShapeQuery(&query, shapes, playerRect); (i = NextShape(&query)) >= 0;) {
+        if (CheckShapeRec(shapes, i, playerRect)) {
+            *transitionIndex = i;
+            return 1;
         }
     }
     return 0;
 }
 
+// "smallFlowerMap" -> "Tiled/Tiledmaps/smallFlowerMap.tmj"
+static void GetTransitionMapPath(const char* targetMap, char* out, int size) {
+    snprintf(out, size, "Tiled/Tiledmaps/%s.tmj", targetMap);
+}
+
+// starts background loads for the targets of transitions near the player
+static void PrefetchNearbyMaps(MapManager* manager, Rectangle playerRect) {
+    GameMap* map = manager->currentMap;
+    const CollisionShapes* shapes = &map->triggerShapes;
+    Rectangle near = {
+        playerRect.x - MAP_PREFETCH_DISTANCE, playerRect.y - MAP_PREFETCH_DISTANCE,
+        playerRect.width + 2 * MAP_PREFETCH_DISTANCE, playerRect.height + 2 * MAP_PREFETCH_DISTANCE
+    };
+    ShapeQuery query;
+    int i;
+    for (BeginShapeQuery(&query, shapes, near); (i = NextShape(&query)) >= 0;) {
+        if (!map->transitions[i].targetMap) continue;
+        // gap between the player and the trigger's bounding box, in world pixels
+        Rectangle box = shapes->bounds[i];
+        float dx = fmaxf(0.0f, fmaxf(box.x - (playerRect.x + playerRect.width),
+                                     playerRect.x - (box.x + box.width)));
+        float dy = fmaxf(0.0f, fmaxf(box.y - (playerRect.y + playerRect.height),
+                                     playerRect.y - (box.y + box.height)));
+        if (dx * dx + dy * dy > MAP_PREFETCH_DISTANCE * MAP_PREFETCH_DISTANCE) continue;
+        char path[512];
+        GetTransitionMapPath(map->transitions[i].targetMap, path, sizeof(path));
+        PrefetchMap(manager->mapCache, path, 0);
+    }
+}
+
 // MARK- Public MapManager functions
 MapManager* CreateMapManager(const char* mapFilePath) {
     MapManager* manager = (MapManager*)malloc(sizeof(MapManager));
@@ -130,14 +93,25 @@ MapManager* CreateMapManager(const char* mapFilePath) {
         // Initialize to NULL/0 first
         manager->entityManager = NULL;
         manager->currentMapName = NULL;
+        manager->pendingMapName = NULL;
+        manager->pendingStart = (Vector2){ 0, 0 };
+        manager->pendingTransition = -1;
+        manager->failedTransition = -1;
+        memset(&manager->renderStats, 0, sizeof(RenderStats));
+        manager->mapCache = CreateMapCache(MAP_CACHE_SIZE);
+        if (!manager->mapCache) {
+            free(manager);
+            return NULL;
+        }
         
         // Load the map
-        manager->currentMap = LoadGameMap(mapFilePath);
+        manager->currentMap = AddCachedMap(manager->mapCache, mapFilePath, LoadGameMap(mapFilePath));
         
         // Create entity manager
         manager->entityManager = CreateEntityManager();
         if (!manager->entityManager) {
             TraceLog(LOG_ERROR, "Failed to create entity manager");
+            DestroyMapCache(manager->mapCache);
             free(manager);
             return NULL;
         }
@@ -163,7 +137,8 @@ MapManager* CreateMapManager(const char* mapFilePath) {
 
 void DestroyMapManager(MapManager* manager) {
     if (manager) {
-        UnloadGameMap(&manager->currentMap);
+        DestroyMapCache(manager->mapCache);
+        free(manager->pendingMapName);
         DestroyEntityManager(manager->entityManager);
         free(manager->currentMapName);
         free(manager);
@@ -172,12 +147,14 @@ void DestroyMapManager(MapManager* manager) {
 
 void SpawnMapEntities(MapManager* manager) {
     TraceLog(LOG_INFO, "Spawning entities for map: %s", manager->currentMapName);
+    // sprite sheets decode in parallel and upload together at the end
+    TextureBatch* sprites = BeginTextureBatch();
     
     if (strcmp(manager->currentMapName, "field") == 0) {
         // Spawn field map entities
         Entity* slime = CreateSlime((Vector2){300, 300}, 2.0f);
         if (slime) {
-            InitEntitySprite(&slime->sprite, 
+            QueueEntitySprite(sprites, &slime->sprite, 
                 "SproutLandsPack/Characters/BasicCharakterSpritesheet.png", 4, 4, 0.1f);
             AddEntity(manager->entityManager, slime);
             TraceLog(LOG_INFO, "Spawned slime at (300, 300)");
@@ -185,7 +162,7 @@ void SpawnMapEntities(MapManager* manager) {
         
         Entity* bat = CreateBat((Vector2){400, 400}, 2.0f);
         if (bat) {
-            InitEntitySprite(&bat->sprite, 
+            QueueEntitySprite(sprites, &bat->sprite, 
                 "SproutLandsPack/Characters/BasicCharakterSpritesheet.png", 4, 4, 0.1f);
             AddEntity(manager->entityManager, bat);
             TraceLog(LOG_INFO, "Spawned bat at (400, 400)");
@@ -195,12 +172,13 @@ void SpawnMapEntities(MapManager* manager) {
         // Spawn cave map entities
         Entity* skeleton = CreateSkeleton((Vector2){200, 200}, 2.0f);
         if (skeleton) {
-            InitEntitySprite(&skeleton->sprite, 
+            QueueEntitySprite(sprites, &skeleton->sprite, 
                 "SproutLandsPack/Characters/BasicCharakterSpritesheet.png", 4, 4, 0.1f);
             AddEntity(manager->entityManager, skeleton);
             TraceLog(LOG_INFO, "Spawned skeleton at (200, 200)");
         }
     }
+    FinishTextureBatch(sprites);
 }
 
 void ClearMapEntities(MapManager* manager) {
@@ -216,8 +194,17 @@ void UpdateMapManager(MapManager* manager, Player* player, float dt) {
     int transitionIndex = -1;
     
     // Use existing CheckMapTransitionCollision function instead of CheckCollisionPolyRec
-    if (CheckMapTransitionCollision(&manager->currentMap, playerRect, PIXEL_SCALE, &transitionIndex)) {
-        MapTransition* transition = &manager->currentMap.transitions[transitionIndex];
+    // (no new transition while one is waiting, the player just keeps playing)
+    int triggered = !manager->pendingMapName &&
+        CheckMapTransitionCollision(manager->currentMap, playerRect, &transitionIndex);
+    // a trigger whose map failed to load stays quiet until the player steps out of it
+    if (transitionIndex != manager->failedTransition)
+        manager->failedTransition = -1;
+    else
+        triggered = 0;
+    if (triggered) {
+        MapTransition* transition = &manager->currentMap->transitions[transitionIndex];
+        TraceLog(LOG_INFO, "Transition %d triggered", transitionIndex);
         
         // Validate transition data
         if (!transition->targetMap) {
@@ -225,65 +212,115 @@ void UpdateMapManager(MapManager* manager, Player* player, float dt) {
             return;
         }
 
+        // Store transition data, the swap happens below once the map is resident
+        manager->pendingMapName = strdup(transition->targetMap);
+        manager->pendingStart = (Vector2){ transition->startX, transition->startY };
+        manager->pendingTransition = transitionIndex;
+
         char newMapPath[512];
-        snprintf(newMapPath, sizeof(newMapPath), "Tiled/Tiledmaps/%s.tmj", transition->targetMap);
-        
-        TraceLog(LOG_INFO, "Loading new map: %s", newMapPath);
-        
-        // Store transition data before clearing anything
-        char* targetMap = strdup(transition->targetMap);
-        float startX = transition->startX;
-        float startY = transition->startY;
-        
-        if (!targetMap) {
-            TraceLog(LOG_ERROR, "Failed to copy target map name");
-            return;
+        GetTransitionMapPath(manager->pendingMapName, newMapPath, sizeof(newMapPath));
+        if (!GetCachedMap(manager->mapCache, newMapPath)) {
+            TraceLog(LOG_INFO, "Loading new map: %s", newMapPath);
+            PrefetchMap(manager->mapCache, newMapPath, 1);
+        }
+    } else if (!manager->pendingMapName) {
+        PrefetchNearbyMaps(manager, playerRect);
+    }
+
+    UpdateMapCache(manager->mapCache, manager->currentMap);
+
+    if (manager->pendingMapName) {
+        char newMapPath[512];
+        GetTransitionMapPath(manager->pendingMapName, newMapPath, sizeof(newMapPath));
+        GameMap* newMap = FindCachedMap(manager->mapCache, newMapPath);
+        if (newMap) {
+            // Clear current map's entities
+            ClearMapEntities(manager);
+            
+            // the old map stays in the cache for the way back
+            manager->currentMap = newMap;
+            MapCacheStats stats = GetMapCacheStats(manager->mapCache);
+            TraceLog(LOG_INFO, "Map cache: %d resident, %d hits, %d misses, %d prefetches, %d evictions",
+                     stats.resident, stats.hits, stats.misses, stats.prefetches, stats.evictions);
+            
+            // Update map name
+            free(manager->currentMapName);
+            manager->currentMapName = manager->pendingMapName;
+            manager->pendingMapName = NULL;
+            
+            // Update player position
+            player->physics.position.x = manager->pendingStart.x;
+            player->physics.position.y = manager->pendingStart.y;
+            
+            // Spawn new map's entities
+            SpawnMapEntities(manager);
+            
+            TraceLog(LOG_INFO, "Map transition complete. New player position: (%.2f, %.2f)", 
+                     player->physics.position.x, player->physics.position.y);
+        } else if (!IsMapLoading(manager->mapCache, newMapPath)) {
+            TraceLog(LOG_ERROR, "Failed to load map %s, staying on %s",
+                     manager->pendingMapName, manager->currentMapName);
+            manager->failedTransition = manager->pendingTransition;
+            free(manager->pendingMapName);
+            manager->pendingMapName = NULL;
         }
-        
-        // Clear current map's entities
-        ClearMapEntities(manager);
-        
-        // Unload current map and load new map
-        UnloadGameMap(&manager->currentMap);
-        manager->currentMap = LoadGameMap(newMapPath);
-        
-        // Update map name
-        free(manager->currentMapName);
-        manager->currentMapName = strdup(targetMap);
-        
-        // Update player position
-        player->physics.position.x = startX;
-        player->physics.position.y = startY;
-        
-        // Spawn new map's entities
-        SpawnMapEntities(manager);
-        
-        TraceLog(LOG_INFO, "Map transition complete. New player position: (%.2f, %.2f)", 
-                 player->physics.position.x, player->physics.position.y);
-        
-        // Clean up
-        free(targetMap);
     }
     
     // Update all entities if movement is enabled
     if (manager->entityManager && ENTITIES_CAN_MOVE) {
-        UpdateEntities(manager->entityManager, &manager->currentMap, dt);
+        UpdateEntities(manager->entityManager, manager->currentMap, dt);
     }
 }
 
-void RenderMapManager(MapManager* manager, float scale) {
+Rectangle GetCameraView(Camera2D camera) {
+    // bounds of all four screen corners, so zoom and rotation are covered
+    float w = (float)GetScreenWidth(), h = (float)GetScreenHeight();
+    Vector2 corners[4] = {
+        GetScreenToWorld2D((Vector2){0, 0}, camera),
+        GetScreenToWorld2D((Vector2){w, 0}, camera),
+        GetScreenToWorld2D((Vector2){0, h}, camera),
+        GetScreenToWorld2D((Vector2){w, h}, camera)
+    };
+    float minX = corners[0].x, maxX = minX, minY = corners[0].y, maxY = minY;
+    for (int i = 1; i < 4; i++) {
+        minX = fminf(minX, corners[i].x);
+        maxX = fmaxf(maxX, corners[i].x);
+        minY = fminf(minY, corners[i].y);
+        maxY = fmaxf(maxY, corners[i].y);
+    }
+    return (Rectangle){ minX, minY, maxX - minX, maxY - minY };
+}
+
+void UpdateMapStreaming(MapManager* manager, Camera2D camera, float scale) {
+    GameMap* map = manager->currentMap;
+    TileView tiles = GetTileView(map, GetCameraView(camera), scale);
+    if (map->infinite)
+        StreamMapChunks(map, tiles.x0, tiles.y0, tiles.x1 - tiles.x0, tiles.y1 - tiles.y0);
+    AnimateMapTiles(map, GetTime());
+    BakeMapTiles(map, tiles);
+}
+
+void RenderMapManager(MapManager* manager, Camera2D camera, float scale) {
+    RenderStats* stats = &manager->renderStats;
+    memset(stats, 0, sizeof(RenderStats));
+    Rectangle view = GetCameraView(camera);
+
     // Render map layers
-    RenderGameMap(&manager->currentMap, scale);
+    GameMap* map = manager->currentMap;
+    RenderMapTiles(map, GetTileView(map, view, scale), scale, stats);
+    // props go in with the entities, the queue sorts them by depth
+    RenderTileObjects(map, view, scale, stats);
     
     // Render entities
-    DrawEntities(manager->entityManager);
+    stats->entitiesDrawn = DrawEntities(manager->entityManager, view);
+    stats->entitiesCulled = manager->entityManager->count - stats->entitiesDrawn;
     
     // Debug rendering if enabled
     #if DEBUG_DRAW_COLLISIONS
-    RenderCollisionPolygons(&manager->currentMap, scale);
+    RenderCollisionPolygons(manager->currentMap);
     #endif
     
     #if DEBUG_DRAW_MAPTRANSITIONS
-    RenderMapTransitionPolygons(&manager->currentMap, scale);
+    RenderMapTransitionPolygons(manager->currentMap);
     #endif
 }
@@ -2,14 +2,22 @@
 #define MAP_MANAGER_H
 
 #include "tiled_loader.h"
+#include "map_render.h"
+#include "map_cache.h"
 #include "entity_manager.h"
 #include "raylib.h"
 #include "player.h"
 
 typedef struct MapManager {
-    GameMap currentMap;
+    GameMap* currentMap;          // owned by mapCache
     EntityManager* entityManager;  // Each map has its own entity manager
     char* currentMapName;         // Store current map name for reference
+    MapCache* mapCache;           // resident maps, prefetches transition targets
+    char* pendingMapName;         // transition waiting for its map, NULL when none
+    Vector2 pendingStart;         // player position once it is swapped in
+    int pendingTransition;        // trigger that started it
+    int failedTransition;         // trigger whose map failed to load, quiet until the player leaves it, -1 for none
+    RenderStats renderStats;      // filled by RenderMapManager
 } MapManager;
 
 MapManager* CreateMapManager(const char* mapFilePath);
@@ -18,11 +26,22 @@ void DestroyMapManager(MapManager* manager);
 
 // Updates the map manager:
 // - Updates the player (moveme, collision...) on the current map
-// - Checks for map transition collisions if found unloads current map and loads target map
+// - Prefetches the targets of transitions the player gets close to
+// - Checks for map transition collisions if found swaps in the target map
+//   (right away when it was prefetched, else once its background load is done)
 void UpdateMapManager(MapManager* manager, Player* player, float dt);
 
-//renders current map all tile layers plus debug
-void RenderMapManager(MapManager* manager, float scale);
+// decodes the chunks of infinite maps around the camera (dropping far away
+// ones), advances animated tiles and bakes the tile chunks it sees, call
+// once per frame after the camera moved and before BeginDrawing, with the
+// scale RenderMapManager draws at
+void UpdateMapStreaming(MapManager* manager, Camera2D camera, float scale);
+
+// world space rectangle the camera shows
+Rectangle GetCameraView(Camera2D camera);
+
+//renders the part of the current map and its entities the camera sees, plus debug
+void RenderMapManager(MapManager* manager, Camera2D camera, float scale);
 
 // Add these new functions
 void SpawnMapEntities(MapManager* manager);
@@ -0,0 +1,119 @@
+#include "map_objects.h"
+#include "constants.h"
+#include "render_queue.h"
+#include "tile_data.h"
+#include <stdlib.h>
+#include <math.h>
+
+void BuildTileObjectGrid(GameMap* map) {
+    TileObjectGrid* grid = &map->objectGrid;
+    *grid = (TileObjectGrid){ 0 };
+    int count = map->tileObjectCount;
+    if (count <= 0) return;
+
+    float minX = map->tileObjects[0].x, maxX = minX;
+    float minY = map->tileObjects[0].y, maxY = minY;
+    for (int i = 0; i < count; i++) {
+        const TileObject* obj = &map->tileObjects[i];
+        minX = fminf(minX, obj->x);
+        maxX = fmaxf(maxX, obj->x);
+        minY = fminf(minY, obj->y);
+        maxY = fmaxf(maxY, obj->y);
+        grid->reachX = fmaxf(grid->reachX, obj->width);
+        grid->reachY = fmaxf(grid->reachY, obj->height);
+    }
+    // a few props far from the rest should not make a huge grid, buckets
+    // grow until there are not many more of them than objects
+    int size = OBJECT_BUCKET_TILES * map->tileWidth;
+    for (;;) {
+        grid->x = (int)floorf(minX / size);
+        grid->y = (int)floorf(minY / size);
+        grid->width = (int)floorf(maxX / size) - grid->x + 1;
+        grid->height = (int)floorf(maxY / size) - grid->y + 1;
+        if ((long long)grid->width * grid->height <= (long long)count * 4 + 16) break;
+        size *= 2;
+    }
+    grid->bucketSize = size;
+
+    // counting sort by bucket
+    int cells = grid->width * grid->height;
+    unsigned int* starts = (unsigned int*)ArenaAllocZero(map->arena, (cells + 1) * sizeof(unsigned int));
+    TileObject* sorted = (TileObject*)ArenaAlloc(map->arena, count * sizeof(TileObject));
+    int* buckets = (int*)malloc(count * sizeof(int));
+    unsigned int* next = (unsigned int*)malloc(cells * sizeof(unsigned int));
+    if (!starts || !sorted || !buckets || !next) {
+        TraceLog(LOG_WARNING, "Out of memory for %d tile objects, they are not drawn", count);
+        free(buckets);
+        free(next);
+        *grid = (TileObjectGrid){ 0 };
+        map->tileObjectCount = 0;
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        const TileObject* obj = &map->tileObjects[i];
+        int bx = (int)floorf(obj->x / size) - grid->x;
+        int by = (int)floorf(obj->y / size) - grid->y;
+        buckets[i] = by * grid->width + bx;
+        starts[buckets[i] + 1]++;
+    }
+    for (int b = 0; b < cells; b++) {
+        starts[b + 1] += starts[b];
+        next[b] = starts[b];
+    }
+    for (int i = 0; i < count; i++)
+        sorted[next[buckets[i]]++] = map->tileObjects[i];
+    free(buckets);
+    free(next);
+    map->tileObjects = sorted;
+    grid->starts = starts;
+}
+
+void RenderTileObjects(GameMap* map, Rectangle view, float scale, RenderStats* stats) {
+    const TileObjectGrid* grid = &map->objectGrid;
+    if (map->tileObjectCount <= 0 || !grid->starts) return;
+    float left = view.x / scale, top = view.y / scale;
+    float right = left + view.width / scale, bottom = top + view.height / scale;
+
+    // objects reach right and up from the bucket of their bottom-left corner
+    float size = (float)grid->bucketSize;
+    int bx0 = (int)floorf((left - grid->reachX) / size) - grid->x;
+    int bx1 = (int)floorf(right / size) - grid->x;
+    int by0 = (int)floorf(top / size) - grid->y;
+    int by1 = (int)floorf((bottom + grid->reachY) / size) - grid->y;
+    if (bx0 < 0) bx0 = 0;
+    if (by0 < 0) by0 = 0;
+    if (bx1 >= grid->width) bx1 = grid->width - 1;
+    if (by1 >= grid->height) by1 = grid->height - 1;
+
+    int drawn = 0;
+    for (int by = by0; by <= by1; by++) {
+        for (int bx = bx0; bx <= bx1; bx++) {
+            int bucket = by * grid->width + bx;
+            for (unsigned int i = grid->starts[bucket]; i < grid->starts[bucket + 1]; i++) {
+                const TileObject* obj = &map->tileObjects[i];
+                if (obj->x >= right || obj->x + obj->width <= left ||
+                    obj->y <= top || obj->y - obj->height >= bottom)
+                    continue;
+                if (obj->tile >= map->drawTableSize) continue;
+                const TileDraw* draw = &map->drawTable[obj->tile];
+                if (draw->texture.id == 0) continue;
+
+                Rectangle source = draw->source;
+                if (obj->flip & TILE_FLIP_HORIZONTAL) source.width = -source.width;
+                if (obj->flip & TILE_FLIP_VERTICAL) source.height = -source.height;
+                Rectangle dest = {
+                    obj->x * scale,
+                    (obj->y - obj->height) * scale,
+                    obj->width * scale,
+                    obj->height * scale
+                };
+                // sorted by its bottom edge, like an entity's feet
+                QueueSprite(RENDER_LAYER_ENTITIES, obj->y * scale, draw->texture, source, dest,
+                            (Vector2){ 0, 0 }, 0.0f, WHITE);
+                drawn++;
+            }
+        }
+    }
+    stats->objectsDrawn += drawn;
+    stats->objectsCulled += map->tileObjectCount - drawn;
+}
@@ -0,0 +1,30 @@
+#ifndef MAP_OBJECTS_H
+#define MAP_OBJECTS_H
+
+#include "tiled_loader.h"
+#include "map_render.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tile objects (trees, chests, furniture placed as "gid" objects in any
+// object layer besides Collision and MapTransition) are kept as one flat
+// TileObject array in the map arena, grouped by a coarse grid of buckets.
+// Drawing only walks the buckets around the view, and each object goes into
+// the render queue next to the entities with its bottom edge as depth, so
+// the player walks behind a tree and in front of it. Tiled's object
+// rotation is not supported, rotated objects are drawn upright.
+
+// Sorts map->tileObjects into buckets (stable, file order is kept within a
+// bucket) and fills map->objectGrid, in the map's arena
+void BuildTileObjectGrid(GameMap* map);
+
+// queues every tile object overlapping view (world space, map pixels times scale)
+void RenderTileObjects(GameMap* map, Rectangle view, float scale, RenderStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,391 @@
+#include "map_render.h"
+#include "constants.h"
+#include "render_queue.h"
+#include "tile_data.h"
+#include "map_chunks.h"
+#include "tile_layers.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef struct {
+    RenderTexture2D target;  // id 0 while not baked
+    int dirty;
+    unsigned int lastUsed;   // bake->frame when last drawn
+    uint64_t animated;       // bit (index % 64) of every animated tile baked in
+} BakedChunk;
+
+struct MapBake {
+    int originX, originY;    // top-left tile of chunk 0
+    int chunksX, chunksY;
+    BakedChunk* chunks;
+    size_t bytes;            // of every baked texture
+    unsigned int frame;
+    int bakedThisFrame;
+};
+
+TileView GetTileView(const GameMap* map, Rectangle view, float scale) {
+    float tileWidth = map->tileWidth * scale;
+    float tileHeight = map->tileHeight * scale;
+    TileView tiles;
+    tiles.x0 = (int)floorf(view.x / tileWidth);
+    tiles.y0 = (int)floorf(view.y / tileHeight);
+    tiles.x1 = (int)ceilf((view.x + view.width) / tileWidth);
+    tiles.y1 = (int)ceilf((view.y + view.height) / tileHeight);
+    return tiles;
+}
+
+// Tiled applies the diagonal flip first, which is a 90 degree turn of a
+// vertically flipped tile, then the horizontal/vertical flips on top. Those
+// two swap axes when the tile is turned, so they are folded into the source flip
+static void DrawFlippedTile(float depth, Texture2D texture, Rectangle sourceRec, Rectangle destRec, unsigned char flip) {
+    int flipX = (flip & TILE_FLIP_HORIZONTAL) != 0;
+    int flipY = (flip & TILE_FLIP_VERTICAL) != 0;
+    float rotation = 0.0f;
+    if (flip & TILE_FLIP_DIAGONAL) {
+        int turnedX = flipY;
+        flipY = !flipX;
+        flipX = turnedX;
+        rotation = 90.0f;
+    }
+    if (flipX) sourceRec.width = -sourceRec.width;
+    if (flipY) sourceRec.height = -sourceRec.height;
+    // rotate around the tile centre so it stays in its cell
+    Vector2 origin = { destRec.width / 2.0f, destRec.height / 2.0f };
+    destRec.x += origin.x;
+    destRec.y += origin.y;
+    QueueSprite(RENDER_LAYER_TILES, depth, texture, sourceRec, destRec, origin, rotation, WHITE);
+}
+
+// ids past the table can not be drawn, TILE_NONE is always one of them
+static unsigned int DrawableTiles(const GameMap* map) {
+    return map->drawTableSize < (int)TILE_NONE ? (unsigned int)map->drawTableSize : TILE_NONE;
+}
+
+// one cell, tile and flip as stored in the layer
+static void RenderTile(GameMap* map, float depth, unsigned int tile, unsigned char flip,
+                       int x, int y, float scale, RenderStats* stats) {
+    const TileDraw* draw = &map->drawTable[tile];
+    if (draw->texture.id == 0) return;
+
+    Rectangle destRec = {
+        x * map->tileWidth * scale,
+        y * map->tileHeight * scale,
+        map->tileWidth * scale,
+        map->tileHeight * scale
+    };
+    if (flip)
+        DrawFlippedTile(depth, draw->texture, draw->source, destRec, flip);
+    else
+        QueueSprite(RENDER_LAYER_TILES, depth, draw->texture, draw->source, destRec, (Vector2){0, 0}, 0.0f, WHITE);
+    stats->tilesDrawn++;
+}
+
+// draws the part of a width x height block of tiles (top-left tile at
+// originX, originY) that falls inside view, depth is the layer's index
+static void RenderTiles(GameMap* map, float depth, const TileId* tiles, const unsigned char* flips,
+                        int width, int height, int originX, int originY,
+                        TileView view, float scale, RenderStats* stats) {
+    int x0 = view.x0 - originX > 0 ? view.x0 - originX : 0;
+    int y0 = view.y0 - originY > 0 ? view.y0 - originY : 0;
+    int x1 = view.x1 - originX < width ? view.x1 - originX : width;
+    int y1 = view.y1 - originY < height ? view.y1 - originY : height;
+    if (x0 >= x1 || y0 >= y1) {
+        stats->tilesCulled += width * height;
+        return;
+    }
+    stats->tilesCulled += width * height - (x1 - x0) * (y1 - y0);
+
+    unsigned int drawable = DrawableTiles(map);
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            // one unsigned compare skips empty cells and ids past the table
+            unsigned int tile = tiles[y * width + x];
+            if (tile >= drawable) continue;
+            RenderTile(map, depth, tile, flips ? flips[y * width + x] : 0, originX + x, originY + y, scale, stats);
+        }
+    }
+}
+
+// sparse layers: rows outside view are skipped, and in the rest only the
+// runs crossing view are walked, the empty cells between them cost nothing
+static void RenderRuns(GameMap* map, float depth, const TileLayer* layer,
+                       TileView view, float scale, RenderStats* stats) {
+    int x0 = view.x0 > 0 ? view.x0 : 0;
+    int y0 = view.y0 > 0 ? view.y0 : 0;
+    int x1 = view.x1 < layer->width ? view.x1 : layer->width;
+    int y1 = view.y1 < layer->height ? view.y1 : layer->height;
+    int visited = 0;
+    unsigned int drawable = DrawableTiles(map);
+    for (int y = y0; y < y1 && x0 < x1; y++) {
+        unsigned int end = layer->rowRuns[y + 1];
+        for (unsigned int r = FindTileRun(layer, x0, y); r < end && layer->runs[r].x < x1; r++) {
+            const TileRun* run = &layer->runs[r];
+            int from = run->x > x0 ? run->x : x0;
+            int to = run->x + run->length < x1 ? run->x + run->length : x1;
+            for (int x = from; x < to; x++) {
+                unsigned int cell = run->first + (x - run->x);
+                unsigned int tile = layer->tiles[cell];
+                if (tile < drawable)
+                    RenderTile(map, depth, tile, layer->flips ? layer->flips[cell] : 0, x, y, scale, stats);
+            }
+            visited += to - from;
+        }
+    }
+    stats->tilesCulled += layer->tileCount - visited;
+}
+
+static void RenderLayer(GameMap* map, int index, TileView view, float scale, RenderStats* stats) {
+    TileLayer* layer = &map->tileLayers[index];
+    if (layer->rowRuns) {
+        RenderRuns(map, (float)index, layer, view, scale, stats);
+        return;
+    }
+    if (layer->tiles) {
+        RenderTiles(map, (float)index, layer->tiles, layer->flips, layer->width, layer->height, 0, 0, view, scale, stats);
+        return;
+    }
+    // infinite layer: whatever UpdateMapStreaming decoded around the camera
+    for (int i = 0; i < layer->chunkCount; i++) {
+        TileChunk* chunk = &layer->chunks[i];
+        if (chunk->tiles)
+            RenderTiles(map, (float)index, chunk->tiles, chunk->flips, chunk->width, chunk->height,
+                        chunk->x, chunk->y, view, scale, stats);
+    }
+}
+
+static void RenderLayers(GameMap* map, TileView view, float scale, RenderStats* stats) {
+    for (int i = 0; i < map->tileLayerCount; i++)
+        RenderLayer(map, i, view, scale, stats);
+}
+
+// the bake grid covers every layer, infinite ones by their chunk grids
+static struct MapBake* CreateMapBake(const GameMap* map) {
+    int x0 = 0, y0 = 0, x1 = map->mapWidth, y1 = map->mapHeight;
+    for (int i = 0; i < map->tileLayerCount; i++) {
+        const TileLayer* layer = &map->tileLayers[i];
+        if (layer->tiles) {
+            if (layer->width > x1) x1 = layer->width;
+            if (layer->height > y1) y1 = layer->height;
+        } else if (layer->chunkGrid) {
+            int lx = layer->gridX * layer->chunkWidth, ly = layer->gridY * layer->chunkHeight;
+            if (lx < x0) x0 = lx;
+            if (ly < y0) y0 = ly;
+            if (lx + layer->gridWidth * layer->chunkWidth > x1) x1 = lx + layer->gridWidth * layer->chunkWidth;
+            if (ly + layer->gridHeight * layer->chunkHeight > y1) y1 = ly + layer->gridHeight * layer->chunkHeight;
+        }
+    }
+    struct MapBake* bake = (struct MapBake*)calloc(1, sizeof(struct MapBake));
+    if (!bake) return NULL;
+    bake->originX = x0;
+    bake->originY = y0;
+    bake->chunksX = (x1 - x0 + BAKE_CHUNK_TILES - 1) / BAKE_CHUNK_TILES;
+    bake->chunksY = (y1 - y0 + BAKE_CHUNK_TILES - 1) / BAKE_CHUNK_TILES;
+    bake->chunks = (BakedChunk*)calloc(bake->chunksX * bake->chunksY > 0 ? bake->chunksX * bake->chunksY : 1,
+                                       sizeof(BakedChunk));
+    if (!bake->chunks) {
+        free(bake);
+        return NULL;
+    }
+    return bake;
+}
+
+// bake chunk range overlapping a tile rectangle, clamped to the grid
+static int ChunkRange(const struct MapBake* bake, TileView view, int* cx0, int* cy0, int* cx1, int* cy1) {
+    int x0 = (int)floorf((float)(view.x0 - bake->originX) / BAKE_CHUNK_TILES);
+    int y0 = (int)floorf((float)(view.y0 - bake->originY) / BAKE_CHUNK_TILES);
+    int x1 = (int)floorf((float)(view.x1 - 1 - bake->originX) / BAKE_CHUNK_TILES);
+    int y1 = (int)floorf((float)(view.y1 - 1 - bake->originY) / BAKE_CHUNK_TILES);
+    *cx0 = x0 < 0 ? 0 : x0;
+    *cy0 = y0 < 0 ? 0 : y0;
+    *cx1 = x1 >= bake->chunksX ? bake->chunksX - 1 : x1;
+    *cy1 = y1 >= bake->chunksY ? bake->chunksY - 1 : y1;
+    return *cx0 <= *cx1 && *cy0 <= *cy1;
+}
+
+static TileView ChunkTiles(const struct MapBake* bake, int cx, int cy) {
+    TileView tiles;
+    tiles.x0 = bake->originX + cx * BAKE_CHUNK_TILES;
+    tiles.y0 = bake->originY + cy * BAKE_CHUNK_TILES;
+    tiles.x1 = tiles.x0 + BAKE_CHUNK_TILES;
+    tiles.y1 = tiles.y0 + BAKE_CHUNK_TILES;
+    return tiles;
+}
+
+// which animated tiles the chunk shows, so only their frame changes rebake it
+static uint64_t ChunkAnimations(const GameMap* map, TileView tiles) {
+    uint64_t animated = 0;
+    for (int i = 0; i < map->tileLayerCount; i++) {
+        const TileLayer* layer = &map->tileLayers[i];
+        for (int y = tiles.y0; y < tiles.y1; y++) {
+            for (int x = tiles.x0; x < tiles.x1; x++) {
+                unsigned int tile = (unsigned int)GetLayerTile(layer, x, y, NULL);
+                if (tile < (unsigned int)map->drawTableSize && map->tileAnimations[tile] >= 0)
+                    animated |= (uint64_t)1 << (map->tileAnimations[tile] & 63);
+            }
+        }
+    }
+    return animated;
+}
+
+static size_t ChunkBytes(const GameMap* map) {
+    return (size_t)BAKE_CHUNK_TILES * map->tileWidth * BAKE_CHUNK_TILES * map->tileHeight * 4;
+}
+
+static void UnbakeChunk(GameMap* map, BakedChunk* chunk) {
+    if (chunk->target.id == 0) return;
+    UnloadRenderTexture(chunk->target);
+    chunk->target = (RenderTexture2D){0};
+    map->bake->bytes -= ChunkBytes(map);
+}
+
+static void BakeChunk(GameMap* map, int cx, int cy) {
+    struct MapBake* bake = map->bake;
+    BakedChunk* chunk = &bake->chunks[cy * bake->chunksX + cx];
+    if (chunk->target.id == 0) {
+        // baked at the art's own resolution, RenderMapTiles scales it up
+        chunk->target = LoadRenderTexture(BAKE_CHUNK_TILES * map->tileWidth, BAKE_CHUNK_TILES * map->tileHeight);
+        if (chunk->target.id == 0) return;
+        bake->bytes += ChunkBytes(map);
+    }
+    TileView tiles = ChunkTiles(bake, cx, cy);
+    Camera2D camera = { 0 };
+    camera.target = (Vector2){ (float)(tiles.x0 * map->tileWidth), (float)(tiles.y0 * map->tileHeight) };
+    camera.zoom = 1.0f;
+    RenderStats ignored = { 0 };
+    BeginTextureMode(chunk->target);
+        ClearBackground(BLANK);
+        BeginMode2D(camera);
+            RenderLayers(map, tiles, 1.0f, &ignored);
+        EndMode2D();
+    EndTextureMode();
+    chunk->dirty = 0;
+    chunk->animated = map->tileAnimations ? ChunkAnimations(map, tiles) : 0;
+    bake->bakedThisFrame++;
+}
+
+// least recently drawn first, never a chunk drawn this frame
+static void TrimMapBake(GameMap* map) {
+    struct MapBake* bake = map->bake;
+    while (bake->bytes > BAKE_MEMORY_BUDGET) {
+        BakedChunk* oldest = NULL;
+        for (int i = 0; i < bake->chunksX * bake->chunksY; i++) {
+            BakedChunk* chunk = &bake->chunks[i];
+            if (chunk->target.id == 0 || chunk->lastUsed == bake->frame) continue;
+            if (!oldest || chunk->lastUsed < oldest->lastUsed)
+                oldest = chunk;
+        }
+        if (!oldest) break;
+        UnbakeChunk(map, oldest);
+    }
+}
+
+void BakeMapTiles(GameMap* map, TileView view) {
+    if (!map->drawTable) return;   // no textures yet
+    if (!map->bake) {
+        map->bake = CreateMapBake(map);
+        if (!map->bake) return;
+    }
+    struct MapBake* bake = map->bake;
+    bake->frame++;
+    bake->bakedThisFrame = 0;
+    int cx0, cy0, cx1, cy1;
+    if (!ChunkRange(bake, view, &cx0, &cy0, &cx1, &cy1)) return;
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            BakedChunk* chunk = &bake->chunks[cy * bake->chunksX + cx];
+            chunk->lastUsed = bake->frame;
+            if (chunk->target.id == 0 || chunk->dirty)
+                BakeChunk(map, cx, cy);
+        }
+    }
+    TrimMapBake(map);
+}
+
+void RenderMapTiles(GameMap* map, TileView view, float scale, RenderStats* stats) {
+    struct MapBake* bake = map->bake;
+    if (!bake) {
+        RenderLayers(map, view, scale, stats);
+        return;
+    }
+    stats->chunksBaked = bake->bakedThisFrame;
+    int cx0, cy0, cx1, cy1;
+    int visible = ChunkRange(bake, view, &cx0, &cy0, &cx1, &cy1);
+    int drawn = 0;
+    for (int cy = cy0; visible && cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            BakedChunk* chunk = &bake->chunks[cy * bake->chunksX + cx];
+            TileView tiles = ChunkTiles(bake, cx, cy);
+            if (chunk->target.id == 0 || chunk->dirty) {
+                // not baked (BakeMapTiles was skipped), draw its tiles instead
+                TileView clipped = tiles;
+                if (clipped.x0 < view.x0) clipped.x0 = view.x0;
+                if (clipped.y0 < view.y0) clipped.y0 = view.y0;
+                if (clipped.x1 > view.x1) clipped.x1 = view.x1;
+                if (clipped.y1 > view.y1) clipped.y1 = view.y1;
+                RenderLayers(map, clipped, scale, stats);
+                continue;
+            }
+            // render textures are stored upside down
+            Texture2D texture = chunk->target.texture;
+            Rectangle source = { 0, 0, (float)texture.width, -(float)texture.height };
+            Rectangle dest = {
+                tiles.x0 * map->tileWidth * scale,
+                tiles.y0 * map->tileHeight * scale,
+                texture.width * scale,
+                texture.height * scale
+            };
+            QueueSprite(RENDER_LAYER_TILES, 0.0f, texture, source, dest, (Vector2){0, 0}, 0.0f, WHITE);
+            chunk->lastUsed = bake->frame;
+            drawn++;
+        }
+    }
+    stats->chunksDrawn += drawn;
+    stats->chunksCulled += bake->chunksX * bake->chunksY - drawn;
+}
+
+void AnimateMapTiles(GameMap* map, double time) {
+    if (map->animatedTileCount == 0) return;
+    long long ms = (long long)(time * 1000.0);
+    uint64_t changed = 0;
+    for (int i = 0; i < map->animatedTileCount; i++) {
+        AnimatedTile* animated = &map->animatedTiles[i];
+        int cycle = animated->frameEnds[animated->frameCount - 1];
+        int t = (int)(ms % cycle);
+        int frame = 0;
+        while (animated->frameEnds[frame] <= t) frame++;
+        if (frame == animated->current) continue;
+        animated->current = frame;
+        map->drawTable[animated->tile] = animated->frames[frame];
+        changed |= (uint64_t)1 << (i & 63);
+    }
+    struct MapBake* bake = map->bake;
+    if (!changed || !bake) return;
+    for (int i = 0; i < bake->chunksX * bake->chunksY; i++) {
+        if (bake->chunks[i].animated & changed)
+            bake->chunks[i].dirty = 1;
+    }
+}
+
+void MarkMapTilesDirty(GameMap* map, int tileX, int tileY, int tileWidth, int tileHeight) {
+    struct MapBake* bake = map->bake;
+    if (!bake || tileWidth <= 0 || tileHeight <= 0) return;
+    TileView tiles = { tileX, tileY, tileX + tileWidth, tileY + tileHeight };
+    int cx0, cy0, cx1, cy1;
+    if (!ChunkRange(bake, tiles, &cx0, &cy0, &cx1, &cy1)) return;
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++)
+            bake->chunks[cy * bake->chunksX + cx].dirty = 1;
+    }
+}
+
+void UnloadMapBake(GameMap* map) {
+    struct MapBake* bake = map->bake;
+    if (!bake) return;
+    for (int i = 0; i < bake->chunksX * bake->chunksY; i++)
+        UnbakeChunk(map, &bake->chunks[i]);
+    free(bake->chunks);
+    free(bake);
+    map->bake = NULL;
+}
@@ -0,0 +1,60 @@
+#ifndef MAP_RENDER_H
+#define MAP_RENDER_H
+
+#include "tiled_loader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tile layers never change while playing, so they are drawn once into
+// BAKE_CHUNK_TILES square render textures (all layers composited, they all
+// go below the entities) and each frame only draws the visible ones. A
+// baked chunk is drawn again only after MarkMapTilesDirty touches it.
+// Baked chunks past BAKE_MEMORY_BUDGET are dropped least recently drawn first.
+
+// what the last RenderMapManager drew and what it skipped as off-screen
+typedef struct {
+    int tilesDrawn;      // tiles drawn one by one (not baked yet)
+    int tilesCulled;     // of those layers, tile cells outside the view
+    int chunksDrawn;     // baked chunks drawn
+    int chunksCulled;    // baked chunks outside the view
+    int chunksBaked;     // chunks (re)baked for this frame
+    int objectsDrawn;    // tile objects (map_objects.h)
+    int objectsCulled;
+    int entitiesDrawn;
+    int entitiesCulled;
+} RenderStats;
+
+// visible tiles, x0/y0 inclusive and x1/y1 exclusive, in tile coordinates
+typedef struct {
+    int x0, y0, x1, y1;
+} TileView;
+
+TileView GetTileView(const GameMap* map, Rectangle view, float scale);
+
+// Bakes the visible chunks that are missing or dirty. Render textures can
+// not be drawn to inside BeginMode2D, so call this before BeginDrawing
+// (and outside a render queue, render_queue.h)
+void BakeMapTiles(GameMap* map, TileView view);
+
+// queues every tile layer inside view, baked chunks where they are ready
+void RenderMapTiles(GameMap* map, TileView view, float scale, RenderStats* stats);
+
+// Shows the frame of every animated tile for time (seconds, one clock for
+// all maps) by rewriting its drawTable entry, so cells showing it cost
+// nothing extra. Only baked chunks holding a tile that changed frame get
+// rebaked. Call before BakeMapTiles
+void AnimateMapTiles(GameMap* map, double time);
+
+// the baked chunks covering this tile rectangle are drawn again before use
+void MarkMapTilesDirty(GameMap* map, int tileX, int tileY, int tileWidth, int tileHeight);
+
+// frees the baked chunks (game thread, UnloadGameMap does it)
+void UnloadMapBake(GameMap* map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,7 +1,9 @@
 #include "player.h"
 #include "constants.h"
+#include "map_collision.h"
 #include "raylib.h"
 #include "raymath.h"  // For Vector2 operations
+#include "render_queue.h"
 #include <stdlib.h>
 
 //Collision/Debug Helpers
@@ -15,58 +17,34 @@ Rectangle GetPlayerCollisionRect(const Player* p) {
     return (Rectangle){ p->physics.position.x + offsetX, p->physics.position.y + offsetY, collW, collH };
 }
 
-static int CheckCollisionPolyRectangle(Vector2* poly, int polyCount, Rectangle rec) {
-    Vector2 corners[4] = {
-        { rec.x,             rec.y },
-        { rec.x + rec.width, rec.y },
-        { rec.x + rec.width, rec.y + rec.height },
-        { rec.x,             rec.y + rec.height }
-    };
-    // rectangle corner inside polygon
-    for (int i = 0; i < 4; i++) {
-        if (CheckCollisionPointPoly(corners[i], poly, polyCount))
-            return 1;
-    }
-    // edges
-    Vector2 r1 = corners[0], r2 = corners[1], r3 = corners[2], r4 = corners[3];
-    for (int i = 0; i < polyCount; i++) {
-        Vector2 p1 = poly[i];
-        Vector2 p2 = poly[(i + 1) % polyCount];
-        if (CheckCollisionLines(p1, p2, r1, r2, NULL)) return 1;
-        if (CheckCollisionLines(p1, p2, r2, r3, NULL)) return 1;
-        if (CheckCollisionLines(p1, p2, r3, r4, NULL)) return 1;
-        if (CheckCollisionLines(p1, p2, r4, r1, NULL)) return 1;
-    }
-    return 0;
+static int CheckCollisionObjects(GameMap* map, Rectangle playerRect) {
+    return CheckSolidRec(map, playerRect);
 }
 
-static int CheckCollisionObjects(GameMap* map, Rectangle playerRect, float scale) {
-    for (int i = 0; i < map->collisionLayer.count; i++) {
-        Polygon poly = map->collisionLayer.polygons[i];
-        if (poly.pointCount < 2) continue;
-        if (poly.pointCount > 128) continue;
 
-        Vector2 worldPoly[128];
-        for (int j = 0; j < poly.pointCount; j++) {
-            worldPoly[j].x = poly.points[j].x * scale;
-            worldPoly[j].y = poly.points[j].y * scale;
-        }
-        if (CheckCollisionPolyRectangle(worldPoly, poly.pointCount, playerRect))
-            return 1;
-    }
-    return 0;
+static void SetSpriteFrames(PlayerSprite* ps) {
+    int width = ps->atlas ? ps->atlas->width : ps->texture.width;
+    int height = ps->atlas ? ps->atlas->height : ps->texture.height;
+    ps->frameWidth  = width  / ps->columns;
+    ps->frameHeight = height / ps->rows;
 }
 
-
 static void LoadSpriteSheet(PlayerSprite* ps, const char* path, int rows, int cols) {
-    ps->texture = LoadTexture(path);
+    ps->atlas = FindAtlasImage(path);
+    ps->texture = ps->atlas ? ps->atlas->texture : LoadTexture(path);
     if (ps->texture.id == 0) {
         TraceLog(LOG_ERROR, "Failed to load texture: %s", path);
     }
     ps->rows = rows;
     ps->columns = cols;
-    ps->frameWidth  = ps->texture.width  / cols;
-    ps->frameHeight = ps->texture.height / rows;
+    SetSpriteFrames(ps);
+}
+
+// the walk sheet is also the active sprite, both need the frame size
+static void WalkSpriteLoaded(void* user) {
+    Player* p = (Player*)user;
+    SetSpriteFrames(&p->walkSprite);
+    p->sprite = p->walkSprite;
 }
 
 // Add these new functions
@@ -180,10 +158,21 @@ static Rectangle CreateSuperAttackHitbox(const Player* p, Rectangle collisionRec
 
 //Public
 
-void InitPlayer(Player* p, const char* walkSpritePath, Vector2 startPos, float scaleVal) {
-    LoadSpriteSheet(&p->walkSprite, walkSpritePath, 4, 4);
+void InitPlayer(Player* p, const char* walkSpritePath, Vector2 startPos, float scaleVal, TextureBatch* batch) {
+    p->walkSprite.rows = 4;
+    p->walkSprite.columns = 4;
+    p->walkSprite.frameWidth = 0;
+    p->walkSprite.frameHeight = 0;
+    p->walkSprite.atlas = FindAtlasImage(walkSpritePath);
+    if (p->walkSprite.atlas) {
+        p->walkSprite.texture = p->walkSprite.atlas->texture;
+        WalkSpriteLoaded(p);
+    } else {
+        QueueTexture(batch, walkSpritePath, &p->walkSprite.texture, WalkSpriteLoaded, p);
+    }
 
     p->actionSprite.texture.id = 0;
+    p->actionSprite.atlas = NULL;
     p->actionSprite.rows = 0;
     p->actionSprite.columns = 0;
     p->actionSprite.frameWidth = 0;
@@ -248,10 +237,10 @@ void UpdatePlayer(Player* p, GameMap* map, float dt) {
     // Store old position for collision resolution
     Vector2 oldPos = p->physics.position;
     int isMoving = 0;  // Track if player is actually moving
+    // Track movement direction (the dash below reuses it)
+    Vector2 moveDir = {0.0f, 0.0f};
     
     if (ENTITIES_CAN_MOVE) {
-        // Track movement direction
-        Vector2 moveDir = {0.0f, 0.0f};
         
         // Capture input direction
         if (IsKeyDown(KEY_RIGHT )|| IsKeyDown(KEY_D)) {
@@ -298,13 +287,13 @@ void UpdatePlayer(Player* p, GameMap* map, float dt) {
         // Apply movement
         p->physics.position.x += moveDir.x * speed;
         Rectangle playerRect = GetPlayerCollisionRect(p);
-        if (CheckCollisionObjects(map, playerRect, PIXEL_SCALE)) {
+        if (CheckCollisionObjects(map, playerRect)) {
             p->physics.position.x = oldPos.x;
         }
         
         p->physics.position.y += moveDir.y * speed;
         playerRect = GetPlayerCollisionRect(p);
-        if (CheckCollisionObjects(map, playerRect, PIXEL_SCALE)) {
+        if (CheckCollisionObjects(map, playerRect)) {
             p->physics.position.y = oldPos.y;
         }
     }
@@ -369,13 +358,13 @@ void UpdatePlayer(Player* p, GameMap* map, float dt) {
             // Apply dash movement
             p->physics.position.x += p->physics.dashDirection.x * p->physics.dashSpeed;
             Rectangle playerRect = GetPlayerCollisionRect(p);
-            if (CheckCollisionObjects(map, playerRect, PIXEL_SCALE)) {
+            if (CheckCollisionObjects(map, playerRect)) {
                 p->physics.position.x = oldDashPos.x;
             }
             
             p->physics.position.y += p->physics.dashDirection.y * p->physics.dashSpeed;
             playerRect = GetPlayerCollisionRect(p);
-            if (CheckCollisionObjects(map, playerRect, PIXEL_SCALE)) {
+            if (CheckCollisionObjects(map, playerRect)) {
                 p->physics.position.y = oldDashPos.y;
             }
         } else {
@@ -465,21 +454,24 @@ void DrawPlayer(Player* p) {
         p->sprite.frameHeight * p->physics.scale
     };
     
-    DrawTexturePro(p->sprite.texture, srcRec, destRec, (Vector2){0, 0}, 0.0f, WHITE);
+    // sorted with the monsters by the feet
+    float depth = destRec.y + destRec.height;
+    // a frame trimmed off the atlas entirely has nothing to draw
+    int visible = !p->sprite.atlas || MapAtlasRect(p->sprite.atlas, &srcRec, &destRec);
+    if (visible)
+        QueueSprite(RENDER_LAYER_ENTITIES, depth, p->sprite.texture, srcRec, destRec, (Vector2){0, 0}, 0.0f, WHITE);
     
     // Draw debug collision and attack boxes
     Rectangle collisionRect = GetPlayerCollisionRect(p);
     Color boxColor = p->physics.hitFlashTimer > 0 ? p->physics.hitFlashColor : GREEN;
-    DrawRectangleLines((int)collisionRect.x, (int)collisionRect.y, 
-                       (int)collisionRect.width, (int)collisionRect.height, boxColor);
+    QueueRectangleLines(RENDER_LAYER_DEBUG, 0.0f, collisionRect, boxColor);
     
     if (p->physics.isAttacking) {
-        DrawRectangleLines((int)p->physics.attackHitbox.x, (int)p->physics.attackHitbox.y,
-                          (int)p->physics.attackHitbox.width, (int)p->physics.attackHitbox.height, RED);
+        QueueRectangleLines(RENDER_LAYER_DEBUG, 0.0f, p->physics.attackHitbox, RED);
     }
 
     // Add dash effect
-    if (p->physics.isDashing) {
+    if (p->physics.isDashing && visible) {
         // Draw a trail effect or something similar
         Color dashColor = (Color){255, 255, 255, 128}; // Semi-transparent white
         Vector2 trailOffset = {
@@ -491,18 +483,19 @@ void DrawPlayer(Player* p) {
         trailDestRec.x += trailOffset.x;
         trailDestRec.y += trailOffset.y;
         
-        DrawTexturePro(p->sprite.texture, srcRec, trailDestRec, 
-                      (Vector2){0, 0}, 0.0f, dashColor);
+        // same key as the player, so it stays drawn over it as before
+        QueueSprite(RENDER_LAYER_ENTITIES, depth, p->sprite.texture, srcRec, trailDestRec,
+                    (Vector2){0, 0}, 0.0f, dashColor);
     }
 }
 
 void UnloadPlayer(Player* p) {
     if (p->walkSprite.texture.id != 0) {
-        UnloadTexture(p->walkSprite.texture);
+        ReleaseTexture(p->walkSprite.texture);
         p->walkSprite.texture.id = 0;
     }
     if (p->actionSprite.texture.id != 0) {
-        UnloadTexture(p->actionSprite.texture);
+        ReleaseTexture(p->actionSprite.texture);
         p->actionSprite.texture.id = 0;
     }
 }
@@ -3,6 +3,8 @@
 
 #include "raylib.h"
 #include "tiled_loader.h"
+#include "asset_workers.h"
+#include "texture_atlas.h"
 
 typedef struct Player Player;
 
@@ -21,10 +23,11 @@ typedef enum {
 
 typedef struct PlayerSprite {
     Texture2D texture;
+    const AtlasImage* atlas;//where the sheet sits on texture, NULL when texture is the sheet
     int rows;//rows in sheet
     int columns;//cols in sheet
-    int frameWidth;//texture.width / columns
-    int frameHeight;//texture.height / rows
+    int frameWidth;//sheet width / columns
+    int frameHeight;//sheet height / rows
 } PlayerSprite;
 
 typedef enum {
@@ -80,7 +83,9 @@ typedef struct Player {
     PlayerPhysics physics;
 } Player;
 
-void InitPlayer(Player* p, const char* walkSpritePath, Vector2 startPos, float scaleVal);
+// batch NULL loads the sprite sheet right away, otherwise it is ready
+// (frame size included) once the batch is finished
+void InitPlayer(Player* p, const char* walkSpritePath, Vector2 startPos, float scaleVal, TextureBatch* batch);
 void LoadActionSprite(Player* p, const char* actionSpritePath, int rows, int columns);
 void UpdatePlayer(Player* p, GameMap* map, float dt);
 void DrawPlayer(Player* p);
@@ -0,0 +1,172 @@
+#include "render_queue.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    COMMAND_SPRITE,
+    COMMAND_RECTANGLE_LINES,
+    COMMAND_LINE
+} CommandType;
+
+typedef struct {
+    unsigned char type;
+    Color color;
+    Texture2D texture;
+    Rectangle source;
+    Rectangle dest;      // lines: x, y is the start and width, height the end
+    Vector2 origin;
+    float rotation;
+} RenderCommand;
+
+typedef struct {
+    uint64_t key;        // layer:8 depth:32 texture:24
+    uint32_t command;
+} SortEntry;
+
+static RenderCommand* commands = NULL;
+static SortEntry* entries = NULL;
+static SortEntry* scratch = NULL;
+static int count = 0;
+static int capacity = 0;
+static int queueing = 0;
+static RenderQueueStats lastStats = { 0 };
+
+// float bits that compare like the floats when read as unsigned
+static uint32_t DepthBits(float depth) {
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+static void DrawCommand(const RenderCommand* c) {
+    switch (c->type) {
+        case COMMAND_SPRITE:
+            DrawTexturePro(c->texture, c->source, c->dest, c->origin, c->rotation, c->color);
+            break;
+        case COMMAND_RECTANGLE_LINES:
+            DrawRectangleLines((int)c->dest.x, (int)c->dest.y, (int)c->dest.width, (int)c->dest.height, c->color);
+            break;
+        case COMMAND_LINE:
+            DrawLine((int)c->dest.x, (int)c->dest.y, (int)c->dest.width, (int)c->dest.height, c->color);
+            break;
+    }
+}
+
+// queues c, or draws it when no queue is open (or it can not grow)
+static void Submit(RenderQueueLayer layer, float depth, const RenderCommand* c) {
+    if (!queueing) {
+        DrawCommand(c);
+        return;
+    }
+    if (count == capacity) {
+        int grown = capacity ? capacity * 2 : 1024;
+        RenderCommand* newCommands = (RenderCommand*)realloc(commands, grown * sizeof(RenderCommand));
+        if (newCommands) commands = newCommands;
+        SortEntry* newEntries = (SortEntry*)realloc(entries, grown * sizeof(SortEntry));
+        if (newEntries) entries = newEntries;
+        SortEntry* newScratch = (SortEntry*)realloc(scratch, grown * sizeof(SortEntry));
+        if (newScratch) scratch = newScratch;
+        if (!newCommands || !newEntries || !newScratch) {
+            DrawCommand(c);
+            return;
+        }
+        capacity = grown;
+    }
+    // shapes have no texture of their own, 0 sorts them before sprites
+    uint32_t texture = c->type == COMMAND_SPRITE ? c->texture.id & 0xFFFFFFu : 0;
+    entries[count].key = ((uint64_t)layer << 56) | ((uint64_t)DepthBits(depth) << 24) | texture;
+    entries[count].command = (uint32_t)count;
+    commands[count++] = *c;
+}
+
+// LSD radix sort, a byte per pass. Stable, and passes where every key has
+// the same byte (most of the layer byte, often the texture bytes) are skipped
+static void SortEntries(void) {
+    SortEntry* from = entries;
+    SortEntry* to = scratch;
+    for (int shift = 0; shift < 64; shift += 8) {
+        int histogram[256] = { 0 };
+        for (int i = 0; i < count; i++)
+            histogram[(from[i].key >> shift) & 0xFF]++;
+        if (histogram[(from[0].key >> shift) & 0xFF] == count) continue;
+        int offset = 0;
+        for (int b = 0; b < 256; b++) {
+            int n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+        for (int i = 0; i < count; i++)
+            to[histogram[(from[i].key >> shift) & 0xFF]++] = from[i];
+        SortEntry* swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != entries)
+        memcpy(entries, from, count * sizeof(SortEntry));
+}
+
+void BeginRenderQueue(void) {
+    count = 0;
+    queueing = 1;
+}
+
+void QueueSprite(RenderQueueLayer layer, float depth, Texture2D texture, Rectangle source,
+                 Rectangle dest, Vector2 origin, float rotation, Color tint) {
+    RenderCommand c = { COMMAND_SPRITE, tint, texture, source, dest, origin, rotation };
+    Submit(layer, depth, &c);
+}
+
+void QueueRectangleLines(RenderQueueLayer layer, float depth, Rectangle rec, Color color) {
+    RenderCommand c = { 0 };
+    c.type = COMMAND_RECTANGLE_LINES;
+    c.color = color;
+    c.dest = rec;
+    Submit(layer, depth, &c);
+}
+
+void QueueLine(RenderQueueLayer layer, float depth, Vector2 start, Vector2 end, Color color) {
+    RenderCommand c = { 0 };
+    c.type = COMMAND_LINE;
+    c.color = color;
+    c.dest = (Rectangle){ start.x, start.y, end.x, end.y };
+    Submit(layer, depth, &c);
+}
+
+void FlushRenderQueue(void) {
+    queueing = 0;
+    lastStats = (RenderQueueStats){ 0 };
+    if (count == 0) return;
+    SortEntries();
+    // shapes draw with raylib's default texture, count them as texture 0
+    unsigned int bound = 0;
+    int first = 1;
+    for (int i = 0; i < count; i++) {
+        const RenderCommand* c = &commands[entries[i].command];
+        unsigned int texture = c->type == COMMAND_SPRITE ? c->texture.id : 0;
+        if (first || texture != bound) {
+            lastStats.textureBinds++;
+            bound = texture;
+            first = 0;
+        }
+        DrawCommand(c);
+        lastStats.drawCalls++;
+    }
+    count = 0;
+}
+
+RenderQueueStats GetRenderQueueStats(void) {
+    return lastStats;
+}
+
+void UnloadRenderQueue(void) {
+    free(commands);
+    free(entries);
+    free(scratch);
+    commands = NULL;
+    entries = NULL;
+    scratch = NULL;
+    count = 0;
+    capacity = 0;
+    queueing = 0;
+}
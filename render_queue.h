@@ -0,0 +1,47 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "raylib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// World drawing goes through one queue per frame instead of calling raylib
+// right away. Every command gets a key of (layer, depth, texture), the queue
+// is radix sorted once in FlushRenderQueue and drawn in key order, so
+// sprites sharing a texture end up next to each other and raylib can batch
+// them. Equal keys keep the order they were queued in.
+// Outside BeginRenderQueue/FlushRenderQueue the Queue functions draw
+// immediately (tile baking relies on that). Game thread only.
+
+typedef enum {
+    RENDER_LAYER_TILES,     // depth is the tile layer index
+    RENDER_LAYER_ENTITIES,  // depth is the world y of the sprite's feet
+    RENDER_LAYER_DEBUG      // overlays, above everything else
+} RenderQueueLayer;
+
+// what the last FlushRenderQueue drew
+typedef struct {
+    int drawCalls;      // raylib draw functions called
+    int textureBinds;   // texture switches, each one breaks raylib's batch
+} RenderQueueStats;
+
+void BeginRenderQueue(void);
+void QueueSprite(RenderQueueLayer layer, float depth, Texture2D texture, Rectangle source,
+                 Rectangle dest, Vector2 origin, float rotation, Color tint);
+void QueueRectangleLines(RenderQueueLayer layer, float depth, Rectangle rec, Color color);
+void QueueLine(RenderQueueLayer layer, float depth, Vector2 start, Vector2 end, Color color);
+// sorts and draws everything queued since BeginRenderQueue, inside the same
+// BeginMode2D as the Queue calls
+void FlushRenderQueue(void);
+RenderQueueStats GetRenderQueueStats(void);
+
+// frees the command buffers (on exit)
+void UnloadRenderQueue(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,152 @@
+#include "texture_atlas.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char* path;
+    AtlasImage image;
+} AtlasEntry;
+
+static Texture2D* pages = NULL;
+static int pageCount = 0;
+static AtlasEntry* entries = NULL;  // sorted by path
+static int entryCount = 0;
+
+static int CompareEntries(const void* a, const void* b) {
+    return strcmp(((const AtlasEntry*)a)->path, ((const AtlasEntry*)b)->path);
+}
+
+// "page <file>" and "image <page> <x> <y> <w> <h> <trimX> <trimY> <width> <height> <path>",
+// the path runs to the end of the line since the pack has spaces in names
+static int ParseAtlasLine(char* line, int* pageCapacity, int* entryCapacity) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '\0' || line[0] == '#') return 1;
+
+    if (strncmp(line, "page ", 5) == 0) {
+        if (pageCount == *pageCapacity) {
+            int capacity = *pageCapacity ? *pageCapacity * 2 : 4;
+            Texture2D* grown = (Texture2D*)realloc(pages, capacity * sizeof(Texture2D));
+            if (!grown) return 0;
+            pages = grown;
+            *pageCapacity = capacity;
+        }
+        pages[pageCount] = LoadTexture(line + 5);
+        if (pages[pageCount].id == 0) {
+            TraceLog(LOG_WARNING, "Atlas page %s did not load", line + 5);
+            return 0;
+        }
+        pageCount++;
+        return 1;
+    }
+
+    int page, x, y, w, h, trimX, trimY, width, height, pathStart = 0;
+    if (sscanf(line, "image %d %d %d %d %d %d %d %d %d %n",
+               &page, &x, &y, &w, &h, &trimX, &trimY, &width, &height, &pathStart) != 9 ||
+        pathStart == 0 || page < 0 || page >= pageCount) {
+        TraceLog(LOG_WARNING, "Bad atlas line: %s", line);
+        return 0;
+    }
+    if (entryCount == *entryCapacity) {
+        int capacity = *entryCapacity ? *entryCapacity * 2 : 32;
+        AtlasEntry* grown = (AtlasEntry*)realloc(entries, capacity * sizeof(AtlasEntry));
+        if (!grown) return 0;
+        entries = grown;
+        *entryCapacity = capacity;
+    }
+    AtlasEntry* entry = &entries[entryCount];
+    entry->path = strdup(line + pathStart);
+    if (!entry->path) return 0;
+    entry->image.texture = pages[page];
+    entry->image.region = (Rectangle){ (float)x, (float)y, (float)w, (float)h };
+    entry->image.trimX = trimX;
+    entry->image.trimY = trimY;
+    entry->image.width = width;
+    entry->image.height = height;
+    entryCount++;
+    return 1;
+}
+
+int LoadTextureAtlas(const char* path) {
+    UnloadTextureAtlas();
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        TraceLog(LOG_INFO, "No texture atlas at %s, loading textures one by one", path);
+        return 0;
+    }
+    char line[1024];
+    int version = 0;
+    if (!fgets(line, sizeof(line), file) || sscanf(line, "# atlas %d", &version) != 1 ||
+        version != TEXTURE_ATLAS_VERSION) {
+        TraceLog(LOG_WARNING, "Texture atlas %s is not version %d, rebuild it", path, TEXTURE_ATLAS_VERSION);
+        fclose(file);
+        return 0;
+    }
+    int pageCapacity = 0, entryCapacity = 0, ok = 1;
+    while (ok && fgets(line, sizeof(line), file))
+        ok = ParseAtlasLine(line, &pageCapacity, &entryCapacity);
+    fclose(file);
+    if (!ok) {
+        UnloadTextureAtlas();
+        return 0;
+    }
+    qsort(entries, entryCount, sizeof(AtlasEntry), CompareEntries);
+    TraceLog(LOG_INFO, "Texture atlas: %d images on %d pages", entryCount, pageCount);
+    return 1;
+}
+
+void UnloadTextureAtlas(void) {
+    for (int i = 0; i < pageCount; i++)
+        UnloadTexture(pages[i]);
+    for (int i = 0; i < entryCount; i++)
+        free(entries[i].path);
+    free(pages);
+    free(entries);
+    pages = NULL;
+    entries = NULL;
+    pageCount = 0;
+    entryCount = 0;
+}
+
+const AtlasImage* FindAtlasImage(const char* imagePath) {
+    if (!imagePath || entryCount == 0) return NULL;
+    AtlasEntry key = { 0 };
+    key.path = (char*)imagePath;
+    AtlasEntry* entry = (AtlasEntry*)bsearch(&key, entries, entryCount, sizeof(AtlasEntry), CompareEntries);
+    return entry ? &entry->image : NULL;
+}
+
+int MapAtlasRect(const AtlasImage* image, Rectangle* source, Rectangle* dest) {
+    // clip to the part that was kept, in image coordinates
+    float x0 = source->x, y0 = source->y;
+    float x1 = source->x + source->width, y1 = source->y + source->height;
+    float keptX0 = (float)image->trimX, keptY0 = (float)image->trimY;
+    float keptX1 = keptX0 + image->region.width, keptY1 = keptY0 + image->region.height;
+    float cx0 = x0 > keptX0 ? x0 : keptX0;
+    float cy0 = y0 > keptY0 ? y0 : keptY0;
+    float cx1 = x1 < keptX1 ? x1 : keptX1;
+    float cy1 = y1 < keptY1 ? y1 : keptY1;
+    if (cx0 >= cx1 || cy0 >= cy1 || source->width <= 0 || source->height <= 0) return 0;
+
+    if (dest) {
+        float scaleX = dest->width / source->width;
+        float scaleY = dest->height / source->height;
+        dest->x += (cx0 - x0) * scaleX;
+        dest->y += (cy0 - y0) * scaleY;
+        dest->width = (cx1 - cx0) * scaleX;
+        dest->height = (cy1 - cy0) * scaleY;
+    }
+    source->x = image->region.x + cx0 - keptX0;
+    source->y = image->region.y + cy0 - keptY0;
+    source->width = cx1 - cx0;
+    source->height = cy1 - cy0;
+    return 1;
+}
+
+void ReleaseTexture(Texture2D texture) {
+    if (texture.id == 0) return;
+    for (int i = 0; i < pageCount; i++) {
+        if (pages[i].id == texture.id) return;
+    }
+    UnloadTexture(texture);
+}
@@ -0,0 +1,46 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include "raylib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The SproutLands PNGs are packed offline (atlaspack, see the Makefile) into
+// a few atlas pages plus a text file saying where each image went. Images
+// are trimmed of transparent borders in BASE_TILE_SIZE cells, so tile grids
+// are never cut. Tilesets and sprite sheets found in the atlas draw from its
+// pages, anything else still loads as its own texture. Without the atlas
+// file everything loads one by one as before.
+// Read only once loaded, so lookups are fine from the map loader thread.
+
+#define TEXTURE_ATLAS_VERSION 1
+
+typedef struct {
+    Texture2D texture;   // the atlas page, owned by the atlas
+    Rectangle region;    // where the trimmed image sits in the page
+    int trimX, trimY;    // top-left of that part in the original image
+    int width, height;   // original image size
+} AtlasImage;
+
+// reads the metadata and uploads the pages, 0 when there is no usable atlas
+int LoadTextureAtlas(const char* path);
+void UnloadTextureAtlas(void);
+
+// the packed image, NULL when imagePath was not packed
+const AtlasImage* FindAtlasImage(const char* imagePath);
+
+// Turns source (in the original image) into the matching part of the page
+// and shrinks dest by what was trimmed off. Returns 0 when all of source
+// was trimmed, there is nothing to draw then
+int MapAtlasRect(const AtlasImage* image, Rectangle* source, Rectangle* dest);
+
+// UnloadTexture for textures that may be atlas pages, those stay loaded
+void ReleaseTexture(Texture2D texture);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,174 @@
+#include "tile_data.h"
+#include "raylib.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <zlib.h>
+#ifdef TOPDOWN_ZSTD
+#include <zstd.h>
+#endif
+
+int ParseTileCompression(const char* name, int length) {
+    if (length == 0) return TILE_COMPRESSION_NONE;
+    if (length == 4 && memcmp(name, "zlib", 4) == 0) return TILE_COMPRESSION_ZLIB;
+    if (length == 4 && memcmp(name, "gzip", 4) == 0) return TILE_COMPRESSION_GZIP;
+    if (length == 4 && memcmp(name, "zstd", 4) == 0) return TILE_COMPRESSION_ZSTD;
+    return -1;
+}
+
+// 0x80 marks bytes that are not part of the base64 alphabet
+static unsigned char base64Table[256];
+static int base64TableReady = 0;
+
+static void InitBase64Table(void) {
+    const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    memset(base64Table, 0x80, sizeof(base64Table));
+    for (int i = 0; i < 64; i++)
+        base64Table[(unsigned char)alphabet[i]] = (unsigned char)i;
+    base64TableReady = 1;
+}
+
+// Decodes into out, returns bytes written or -1 on bad input / overflow.
+// The main loop works on whole 4 char blocks with no per-char branches,
+// validity is checked once per block by or-ing the table lookups
+static long DecodeBase64(const char* src, int length, unsigned char* out, long outSize) {
+    if (!base64TableReady)
+        InitBase64Table();
+    // base64 copied out of Tiled's XML format comes padded with whitespace
+    while (length > 0 && (src[length - 1] == '\n' || src[length - 1] == ' ' || src[length - 1] == '\r'))
+        length--;
+    while (length > 0 && (*src == '\n' || *src == ' ' || *src == '\r')) {
+        src++;
+        length--;
+    }
+    if (length % 4 != 0) return -1;
+    int padding = 0;
+    if (length >= 1 && src[length - 1] == '=') padding++;
+    if (length >= 2 && src[length - 2] == '=') padding++;
+    long decodedSize = (long)length / 4 * 3 - padding;
+    if (decodedSize > outSize) return -1;
+
+    const unsigned char* in = (const unsigned char*)src;
+    int fullBlocks = (length / 4) - (padding ? 1 : 0);
+    unsigned char bad = 0;
+    unsigned char* o = out;
+    for (int b = 0; b < fullBlocks; b++, in += 4, o += 3) {
+        unsigned char a = base64Table[in[0]], c = base64Table[in[1]];
+        unsigned char d = base64Table[in[2]], e = base64Table[in[3]];
+        bad |= a | c | d | e;
+        uint32_t v = ((uint32_t)a << 18) | ((uint32_t)c << 12) | ((uint32_t)d << 6) | e;
+        o[0] = (unsigned char)(v >> 16);
+        o[1] = (unsigned char)(v >> 8);
+        o[2] = (unsigned char)v;
+    }
+    if (padding) {
+        unsigned char a = base64Table[in[0]], c = base64Table[in[1]];
+        unsigned char d = padding == 1 ? base64Table[in[2]] : 0;
+        bad |= a | c | d;
+        uint32_t v = ((uint32_t)a << 18) | ((uint32_t)c << 12) | ((uint32_t)d << 6);
+        o[0] = (unsigned char)(v >> 16);
+        if (padding == 1)
+            o[1] = (unsigned char)(v >> 8);
+    }
+    return (bad & 0x80) ? -1 : decodedSize;
+}
+
+static int Inflate(const unsigned char* src, long srcSize, unsigned char* out, long outSize) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // 15 + 32: accept both zlib and gzip headers
+    if (inflateInit2(&stream, 15 + 32) != Z_OK)
+        return 0;
+    stream.next_in = (Bytef*)src;
+    stream.avail_in = (uInt)srcSize;
+    stream.next_out = out;
+    stream.avail_out = (uInt)outSize;
+    int result = inflate(&stream, Z_FINISH);
+    long produced = (long)stream.total_out;
+    inflateEnd(&stream);
+    return result == Z_STREAM_END && produced == outSize;
+}
+
+static int HostIsLittleEndian(void) {
+    const uint16_t probe = 1;
+    return *(const uint8_t*)&probe == 1;
+}
+
+int DecodeTileData(const char* base64, int length, TileCompression compression,
+                   void* out, int count) {
+    long outSize = (long)count * 4;
+    int ok = 0;
+
+    // escaped characters only show up if the writer escaped '/', strip them first
+    char* unescaped = NULL;
+    if (memchr(base64, '\\', length)) {
+        unescaped = (char*)malloc(length);
+        int n = 0;
+        for (int i = 0; i < length; i++) {
+            if (base64[i] == '\\' && i + 1 < length) i++;
+            unescaped[n++] = base64[i];
+        }
+        base64 = unescaped;
+        length = n;
+    }
+
+    if (compression == TILE_COMPRESSION_NONE) {
+        ok = DecodeBase64(base64, length, (unsigned char*)out, outSize) == outSize;
+    } else {
+        long packedCapacity = (long)length / 4 * 3;
+        unsigned char* packed = (unsigned char*)malloc(packedCapacity > 0 ? packedCapacity : 1);
+        long packedSize = packed ? DecodeBase64(base64, length, packed, packedCapacity) : -1;
+        if (packedSize < 0) {
+            TraceLog(LOG_WARNING, "Tile layer data is not valid base64");
+        } else if (compression == TILE_COMPRESSION_ZLIB || compression == TILE_COMPRESSION_GZIP) {
+            ok = Inflate(packed, packedSize, (unsigned char*)out, outSize);
+        } else if (compression == TILE_COMPRESSION_ZSTD) {
+#ifdef TOPDOWN_ZSTD
+            size_t produced = ZSTD_decompress(out, (size_t)outSize, packed, (size_t)packedSize);
+            ok = !ZSTD_isError(produced) && (long)produced == outSize;
+#else
+            TraceLog(LOG_ERROR, "zstd tile layers need the game built with make ZSTD=1");
+#endif
+        }
+        free(packed);
+    }
+    free(unescaped);
+
+    if (ok && !HostIsLittleEndian()) {
+        unsigned char* b = (unsigned char*)out;
+        for (long i = 0; i < outSize; i += 4) {
+            unsigned char t0 = b[i], t1 = b[i + 1];
+            b[i] = b[i + 3];
+            b[i + 1] = b[i + 2];
+            b[i + 2] = t1;
+            b[i + 3] = t0;
+        }
+    }
+    return ok;
+}
+
+int TileGidsHaveFlags(const int* tiles, int count) {
+    const uint32_t* gids = (const uint32_t*)tiles;
+    uint32_t anyFlags = 0;
+    for (int i = 0; i < count; i++)
+        anyFlags |= gids[i];
+    return (anyFlags & ~TILE_GID_MASK) != 0;
+}
+
+int ConvertTileGids(const int* raw, int count, TileId* tiles, unsigned char* flips) {
+    // Branch free so it vectorizes: masking the flags off and subtracting one
+    // turns gid 0 (empty) into 0xFFFFFFFF and every other gid into its 0-based
+    // id, anything from TILE_NONE up then clamps to TILE_NONE
+    const uint32_t* gids = (const uint32_t*)raw;
+    if (flips) {
+        for (int i = 0; i < count; i++)
+            flips[i] = (unsigned char)(gids[i] >> 29);
+    }
+    int dropped = 0;
+    for (int i = 0; i < count; i++) {
+        uint32_t id = (gids[i] & TILE_GID_MASK) - 1u;
+        dropped += id >= TILE_NONE && id != 0xFFFFFFFFu;
+        tiles[i] = (TileId)(id < TILE_NONE ? id : TILE_NONE);
+    }
+    return dropped;
+}
@@ -0,0 +1,54 @@
+#ifndef TILE_DATA_H
+#define TILE_DATA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tiled stores flip/rotation flags in the top bits of every gid
+#define TILE_GID_FLIPPED_HORIZONTALLY 0x80000000u
+#define TILE_GID_FLIPPED_VERTICALLY   0x40000000u
+#define TILE_GID_FLIPPED_DIAGONALLY   0x20000000u
+#define TILE_GID_ROTATED_HEXAGONAL    0x10000000u
+#define TILE_GID_MASK                 0x0FFFFFFFu
+
+// tile ids as layers keep them: 0-based, TILE_NONE where a cell is empty.
+// Ids from TILE_NONE up do not fit and are dropped by ConvertTileGids
+typedef unsigned short TileId;
+#define TILE_NONE 0xFFFFu
+
+// per tile flags kept in TileLayer.flips (gid >> 29)
+#define TILE_FLIP_DIAGONAL   0x1
+#define TILE_FLIP_VERTICAL   0x2
+#define TILE_FLIP_HORIZONTAL 0x4
+
+typedef enum {
+    TILE_COMPRESSION_NONE = 0,
+    TILE_COMPRESSION_ZLIB,     // zlib and gzip share the inflate path
+    TILE_COMPRESSION_GZIP,
+    TILE_COMPRESSION_ZSTD      // needs make ZSTD=1
+} TileCompression;
+
+// "zlib" / "gzip" / "zstd" / "" -> TileCompression, -1 when unknown
+int ParseTileCompression(const char* name, int length);
+
+// Decodes a layer "data" string (base64, optionally compressed) into
+// count little-endian gids written to out (count * 4 bytes).
+// Returns 1 when exactly count gids were produced
+int DecodeTileData(const char* base64, int length, TileCompression compression,
+                   void* out, int count);
+
+// 1 when any raw gid carries flip flags, so the layer needs a flips array
+int TileGidsHaveFlags(const int* tiles, int count);
+
+// Converts raw gids (as written by Tiled, flags included) into TileLayer
+// encoding, count TileIds written to tiles. flips (count bytes, may be NULL)
+// receives the per-tile TILE_FLIP_* flags. Returns how many ids were too
+// big for a TileId, those cells end up empty
+int ConvertTileGids(const int* gids, int count, TileId* tiles, unsigned char* flips);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+#include "tile_layers.h"
+#include "map_chunks.h"
+#include <stdlib.h>
+#include <string.h>
+
+void CompactTileLayer(Arena* arena, TileLayer* layer) {
+    if (!layer->tiles || layer->rowRuns) return;
+    int width = layer->width, height = layer->height;
+    // runs keep x and length in 16 bits
+    if (width <= 0 || height <= 0 || width > 0xFFFF || layer->tileCount != width * height) return;
+
+    // count first so every array is allocated once
+    int runCount = 0, cellCount = 0;
+    for (int y = 0; y < height; y++) {
+        const TileId* row = layer->tiles + (size_t)y * width;
+        for (int x = 0; x < width; x++) {
+            if (row[x] == TILE_NONE) continue;
+            cellCount++;
+            if (x == 0 || row[x - 1] == TILE_NONE) runCount++;
+        }
+    }
+    size_t cellBytes = sizeof(TileId) + (layer->flips ? 1 : 0);
+    size_t dense = (size_t)width * height * cellBytes;
+    size_t sparse = (size_t)runCount * sizeof(TileRun) + (size_t)(height + 1) * sizeof(unsigned int) +
+                    (size_t)cellCount * cellBytes;
+    if (sparse >= dense) return;
+
+    TileRun* runs = (TileRun*)ArenaAlloc(arena, (runCount > 0 ? runCount : 1) * sizeof(TileRun));
+    unsigned int* rowRuns = (unsigned int*)ArenaAlloc(arena, (height + 1) * sizeof(unsigned int));
+    TileId* tiles = (TileId*)ArenaAlloc(arena, (cellCount > 0 ? cellCount : 1) * sizeof(TileId));
+    unsigned char* flips = layer->flips ? (unsigned char*)ArenaAlloc(arena, cellCount > 0 ? cellCount : 1) : NULL;
+    if (!runs || !rowRuns || !tiles || (layer->flips && !flips)) return;
+
+    int run = 0, cell = 0;
+    for (int y = 0; y < height; y++) {
+        rowRuns[y] = (unsigned int)run;
+        const TileId* row = layer->tiles + (size_t)y * width;
+        int x = 0;
+        while (x < width) {
+            if (row[x] == TILE_NONE) {
+                x++;
+                continue;
+            }
+            int start = x;
+            while (x < width && row[x] != TILE_NONE) x++;
+            int length = x - start;
+            runs[run].x = (unsigned short)start;
+            runs[run].length = (unsigned short)length;
+            runs[run].first = (unsigned int)cell;
+            memcpy(tiles + cell, row + start, length * sizeof(TileId));
+            if (flips)
+                memcpy(flips + cell, layer->flips + (size_t)y * width + start, length);
+            cell += length;
+            run++;
+        }
+    }
+    rowRuns[height] = (unsigned int)run;
+
+    layer->tiles = tiles;
+    layer->flips = flips;
+    layer->tileCount = cellCount;
+    layer->runs = runs;
+    layer->rowRuns = rowRuns;
+}
+
+unsigned int FindTileRun(const TileLayer* layer, int x, int y) {
+    // runs in a row are sorted and never overlap, so their ends are sorted too
+    unsigned int low = layer->rowRuns[y], high = layer->rowRuns[y + 1];
+    while (low < high) {
+        unsigned int mid = low + (high - low) / 2;
+        const TileRun* run = &layer->runs[mid];
+        if ((int)run->x + run->length <= x)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+// shaped[id] is 1 for tile ids with collision shapes (size entries), NULL
+// when no tileset has any
+static unsigned char* FindShapedTiles(const GameMap* map, int* size) {
+    *size = 0;
+    for (int i = 0; i < map->tilesetCount; i++) {
+        const Tileset* ts = &map->tilesets[i];
+        if (ts->firstgid < 1 || ts->shapeCount <= 0) continue;
+        int end = ts->firstgid - 1 + ts->shapes[ts->shapeCount - 1].tileId + 1;
+        if (end > *size) *size = end;
+    }
+    if (*size == 0) return NULL;
+    unsigned char* shaped = (unsigned char*)calloc(*size, 1);
+    if (!shaped) return NULL;
+    for (int i = 0; i < map->tilesetCount; i++) {
+        const Tileset* ts = &map->tilesets[i];
+        if (ts->firstgid < 1) continue;
+        for (int j = 0; j < ts->shapeCount; j++) {
+            if (ts->shapes[j].tileId >= 0)
+                shaped[ts->firstgid - 1 + ts->shapes[j].tileId] = 1;
+        }
+    }
+    return shaped;
+}
+
+int FlattenTileLayers(GameMap* map, const unsigned char* opaque, int count) {
+    int width = map->mapWidth, height = map->mapHeight;
+    if (width <= 0 || height <= 0) return 0;
+    // cells an opaque tile already covers, filled from the top layer down
+    unsigned char* covered = (unsigned char*)calloc((size_t)width * height, 1);
+    if (!covered) return 0;
+    // hidden or not, BuildMapCollision places the shapes of these tiles
+    int shapedCount;
+    unsigned char* shaped = FindShapedTiles(map, &shapedCount);
+    if (shapedCount > 0 && !shaped) {
+        free(covered);
+        return 0;
+    }
+
+    int dropped = 0;
+    for (int i = map->tileLayerCount - 1; i >= 0; i--) {
+        TileLayer* layer = &map->tileLayers[i];
+        if (!layer->tiles) continue;
+        // rebuilt dense, CompactTileLayer packs it again below
+        int cells = layer->width * layer->height;
+        TileId* tiles = (TileId*)ArenaAlloc(map->arena, (cells > 0 ? cells : 1) * sizeof(TileId));
+        unsigned char* flips = layer->flips ? (unsigned char*)ArenaAlloc(map->arena, cells > 0 ? cells : 1) : NULL;
+        if (!tiles || (layer->flips && !flips)) break;
+
+        int layerDropped = 0;
+        for (int y = 0; y < layer->height; y++) {
+            for (int x = 0; x < layer->width; x++) {
+                unsigned char flip = 0;
+                int tile = GetLayerTile(layer, x, y, &flip);
+                if (tile >= 0 && x < width && y < height) {
+                    unsigned char* cover = &covered[y * width + x];
+                    if (*cover && !(tile < shapedCount && shaped[tile])) {
+                        tile = -1;
+                        layerDropped++;
+                    } else if (tile < count && opaque[tile]) {
+                        *cover = 1;
+                    }
+                }
+                tiles[y * layer->width + x] = tile < 0 ? (TileId)TILE_NONE : (TileId)tile;
+                if (flips)
+                    flips[y * layer->width + x] = tile < 0 ? 0 : flip;
+            }
+        }
+        if (layerDropped == 0) continue;
+        layer->tiles = tiles;
+        layer->flips = flips;
+        layer->tileCount = cells;
+        layer->runs = NULL;
+        layer->rowRuns = NULL;
+        CompactTileLayer(map->arena, layer);
+        dropped += layerDropped;
+    }
+    free(covered);
+    free(shaped);
+    return dropped;
+}
@@ -0,0 +1,35 @@
+#ifndef TILE_LAYERS_H
+#define TILE_LAYERS_H
+
+#include "tiled_loader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Finite tile layers keep 16-bit ids in one of two shapes: dense, every cell
+// row by row, or sparse, only the runs of non empty cells in each row.
+// CompactTileLayer picks whichever takes less memory, so a decoration layer
+// that is mostly empty costs about what it draws, and the render walk steps
+// over its empty stretches a run at a time.
+
+// Turns a dense layer sparse when that is smaller. New arrays come from
+// arena, the dense ones are left where they are
+void CompactTileLayer(Arena* arena, TileLayer* layer);
+
+// Index of the first run of row y that ends after x, the end of the row's
+// runs when there is none. Sparse layers only, y inside the layer
+unsigned int FindTileRun(const TileLayer* layer, int x, int y);
+
+// Empties every cell that a fully opaque tile in a higher layer covers, so
+// an opaque stack is left as the one tile that shows. opaque[id] is 1 for
+// tile ids that cover their whole cell (count entries). Tiles with collision
+// shapes are never dropped, their shapes still block. Infinite layers are
+// left alone. Returns the number of cells dropped
+int FlattenTileLayers(GameMap* map, const unsigned char* opaque, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,324 @@
+#include "tiled_json.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+int JsonOpenFile(JsonFile* file, const char* path) {
+    file->data = NULL;
+    file->size = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return 0;
+    }
+    void* mapped = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return 0;
+    file->data = (const char*)mapped;
+    file->size = (size_t)st.st_size;
+    return 1;
+}
+
+void JsonCloseFile(JsonFile* file) {
+    if (file->data)
+        munmap((void*)file->data, file->size);
+    file->data = NULL;
+    file->size = 0;
+}
+
+void JsonInit(JsonReader* r, const char* data, size_t size) {
+    r->start = data;
+    r->cur = data;
+    r->end = data + size;
+    r->error = (data == NULL);
+}
+
+static void SkipSpace(JsonReader* r) {
+    while (r->cur < r->end && (*r->cur == ' ' || *r->cur == '\n' || *r->cur == '\r' || *r->cur == '\t'))
+        r->cur++;
+}
+
+static int Fail(JsonReader* r) {
+    r->error = 1;
+    r->cur = r->end;
+    return 0;
+}
+
+// consumes c (after whitespace) if it is next
+static int Accept(JsonReader* r, char c) {
+    SkipSpace(r);
+    if (r->cur < r->end && *r->cur == c) {
+        r->cur++;
+        return 1;
+    }
+    return 0;
+}
+
+// 1 when the last token read was open, so the next member is the first
+// one and needs no comma before it. Looks back over whitespace only: no
+// value ends in a bracket that opens, so finding one means nothing has
+// been read since it. r->start bounds the look back for readers started
+// in the middle of a file (chunk data)
+static int AfterOpen(const JsonReader* r, char open) {
+    const char* p = r->cur;
+    while (p > r->start && (p[-1] == ' ' || p[-1] == '\n' || p[-1] == '\r' || p[-1] == '\t'))
+        p--;
+    return p > r->start && p[-1] == open;
+}
+
+JsonType JsonPeek(JsonReader* r) {
+    SkipSpace(r);
+    if (r->error || r->cur >= r->end) return JSON_ERROR;
+    switch (*r->cur) {
+        case '{': return JSON_OBJECT;
+        case '[': return JSON_ARRAY;
+        case '"': return JSON_STRING;
+        case 't': case 'f': return JSON_BOOL;
+        case 'n': return JSON_NULL;
+        default:
+            if (*r->cur == '-' || (*r->cur >= '0' && *r->cur <= '9'))
+                return JSON_NUMBER;
+            return JSON_ERROR;
+    }
+}
+
+int JsonBeginObject(JsonReader* r) {
+    if (r->error) return 0;
+    return Accept(r, '{') ? 1 : Fail(r);
+}
+
+int JsonNextKey(JsonReader* r, JsonString* key) {
+    if (r->error) return 0;
+    if (Accept(r, '}')) return 0;
+    if (!AfterOpen(r, '{') && !Accept(r, ',')) return Fail(r);
+    if (!JsonReadString(r, key)) return 0;
+    return Accept(r, ':') ? 1 : Fail(r);
+}
+
+int JsonBeginArray(JsonReader* r) {
+    if (r->error) return 0;
+    return Accept(r, '[') ? 1 : Fail(r);
+}
+
+int JsonNextElement(JsonReader* r) {
+    if (r->error) return 0;
+    if (Accept(r, ']')) return 0;
+    if (!AfterOpen(r, '[') && !Accept(r, ',')) return Fail(r);
+    SkipSpace(r);
+    if (r->cur >= r->end) return Fail(r);
+    return 1;
+}
+
+int JsonCountElements(JsonReader* r) {
+    JsonReader probe = *r;
+    int count = 0;
+    if (!JsonBeginArray(&probe)) return 0;
+    while (JsonNextElement(&probe)) {
+        JsonSkipValue(&probe);
+        count++;
+    }
+    return probe.error ? 0 : count;
+}
+
+static int IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// The file is not NUL terminated so strtod is off limits; Tiled only writes
+// plain decimals (and the odd exponent) which this handles exactly enough for float use
+double JsonReadNumber(JsonReader* r) {
+    SkipSpace(r);
+    if (r->error) return 0;
+    const char* p = r->cur;
+    int negative = 0;
+    if (p < r->end && *p == '-') {
+        negative = 1;
+        p++;
+    }
+    if (p >= r->end || !IsDigit(*p)) return Fail(r);
+    double value = 0;
+    while (p < r->end && IsDigit(*p))
+        value = value * 10.0 + (*p++ - '0');
+    if (p < r->end && *p == '.') {
+        p++;
+        double scale = 0.1;
+        while (p < r->end && IsDigit(*p)) {
+            value += (*p++ - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    if (p < r->end && (*p == 'e' || *p == 'E')) {
+        p++;
+        int expNegative = 0, exponent = 0;
+        if (p < r->end && (*p == '+' || *p == '-'))
+            expNegative = (*p++ == '-');
+        while (p < r->end && IsDigit(*p))
+            exponent = exponent * 10 + (*p++ - '0');
+        double factor = 1.0;
+        while (exponent-- > 0 && factor < 1e300)
+            factor *= 10.0;
+        value = expNegative ? value / factor : value * factor;
+    }
+    r->cur = p;
+    return negative ? -value : value;
+}
+
+// fast path for the integer-only arrays that make up most of a map
+unsigned int JsonReadUInt(JsonReader* r) {
+    SkipSpace(r);
+    if (r->error) return 0;
+    const char* p = r->cur;
+    if (p >= r->end || !IsDigit(*p)) {
+        // negative or fractional, let the general path deal with it
+        return (unsigned int)(long long)JsonReadNumber(r);
+    }
+    unsigned long long value = 0;
+    while (p < r->end && IsDigit(*p)) {
+        value = value * 10 + (unsigned)(*p++ - '0');
+        if (value > 0xFFFFFFFFull) return Fail(r);
+    }
+    if (p < r->end && (*p == '.' || *p == 'e' || *p == 'E'))
+        return (unsigned int)JsonReadNumber(r);
+    r->cur = p;
+    return (unsigned int)value;
+}
+
+int JsonReadInt(JsonReader* r) {
+    return (int)JsonReadNumber(r);
+}
+
+int JsonReadBool(JsonReader* r) {
+    SkipSpace(r);
+    if (r->end - r->cur >= 4 && memcmp(r->cur, "true", 4) == 0) {
+        r->cur += 4;
+        return 1;
+    }
+    if (r->end - r->cur >= 5 && memcmp(r->cur, "false", 5) == 0) {
+        r->cur += 5;
+        return 0;
+    }
+    return Fail(r);
+}
+
+int JsonReadString(JsonReader* r, JsonString* out) {
+    out->start = NULL;
+    out->length = 0;
+    if (!Accept(r, '"')) return Fail(r);
+    const char* start = r->cur;
+    while (r->cur < r->end && *r->cur != '"') {
+        if (*r->cur == '\\' && r->cur + 1 < r->end) r->cur++;
+        r->cur++;
+    }
+    if (r->cur >= r->end) return Fail(r);
+    out->start = start;
+    out->length = (int)(r->cur - start);
+    r->cur++;
+    return 1;
+}
+
+void JsonSkipValue(JsonReader* r) {
+    JsonString s;
+    switch (JsonPeek(r)) {
+        case JSON_OBJECT:
+            JsonBeginObject(r);
+            while (JsonNextKey(r, &s))
+                JsonSkipValue(r);
+            break;
+        case JSON_ARRAY:
+            JsonBeginArray(r);
+            while (JsonNextElement(r))
+                JsonSkipValue(r);
+            break;
+        case JSON_STRING:
+            JsonReadString(r, &s);
+            break;
+        case JSON_NUMBER:
+            // numbers are skipped without converting them
+            while (r->cur < r->end && (IsDigit(*r->cur) || *r->cur == '-' || *r->cur == '+' ||
+                                       *r->cur == '.' || *r->cur == 'e' || *r->cur == 'E'))
+                r->cur++;
+            break;
+        case JSON_BOOL:
+            JsonReadBool(r);
+            break;
+        case JSON_NULL:
+            if (r->end - r->cur >= 4 && memcmp(r->cur, "null", 4) == 0)
+                r->cur += 4;
+            else
+                Fail(r);
+            break;
+        default:
+            Fail(r);
+            break;
+    }
+}
+
+int JsonStringEquals(JsonString s, const char* text) {
+    size_t len = strlen(text);
+    return (size_t)s.length == len && memcmp(s.start, text, len) == 0;
+}
+
+static int HexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+int JsonStringCopy(JsonString s, char* out, int outSize) {
+    int n = 0;
+    if (outSize <= 0) return 0;
+    for (int i = 0; i < s.length && n < outSize - 1; i++) {
+        char c = s.start[i];
+        if (c != '\\' || i + 1 >= s.length) {
+            out[n++] = c;
+            continue;
+        }
+        c = s.start[++i];
+        switch (c) {
+            case 'b': out[n++] = '\b'; break;
+            case 'f': out[n++] = '\f'; break;
+            case 'n': out[n++] = '\n'; break;
+            case 'r': out[n++] = '\r'; break;
+            case 't': out[n++] = '\t'; break;
+            case 'u': {
+                unsigned code = 0;
+                int j;
+                for (j = 0; j < 4 && i + 1 < s.length; j++) {
+                    int h = HexValue(s.start[i + 1]);
+                    if (h < 0) break;
+                    code = code * 16 + h;
+                    i++;
+                }
+                // utf-8 encode, surrogate pairs are not worth it for file names
+                if (code < 0x80) {
+                    out[n++] = (char)code;
+                } else if (code < 0x800 && n < outSize - 2) {
+                    out[n++] = (char)(0xC0 | (code >> 6));
+                    out[n++] = (char)(0x80 | (code & 0x3F));
+                } else if (n < outSize - 3) {
+                    out[n++] = (char)(0xE0 | (code >> 12));
+                    out[n++] = (char)(0x80 | ((code >> 6) & 0x3F));
+                    out[n++] = (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: out[n++] = c; break; // \" \\ \/
+        }
+    }
+    out[n] = '\0';
+    return n;
+}
+
+char* JsonStringDup(JsonString s) {
+    // decoding never grows a string
+    char* out = (char*)malloc(s.length + 1);
+    if (out)
+        JsonStringCopy(s, out, s.length + 1);
+    return out;
+}
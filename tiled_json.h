@@ -0,0 +1,81 @@
+#ifndef TILED_JSON_H
+#define TILED_JSON_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Minimal in-situ pull parser for the JSON Tiled writes (.tmj/.tsj).
+// Nothing is allocated: the caller walks the document with the functions
+// below and copies values straight into their final arrays. Strings are
+// slices of the source buffer, only JsonStringCopy decodes escapes.
+
+typedef enum {
+    JSON_ERROR = 0,
+    JSON_OBJECT,
+    JSON_ARRAY,
+    JSON_STRING,
+    JSON_NUMBER,
+    JSON_BOOL,
+    JSON_NULL
+} JsonType;
+
+typedef struct {
+    const char* start;  // first byte, commas are checked by looking back to it
+    const char* cur;
+    const char* end;
+    int error;          // set on the first malformed token, every read after that fails
+} JsonReader;
+
+typedef struct {
+    const char* start;  // raw bytes between the quotes, escapes not decoded
+    int length;
+} JsonString;
+
+// read-only mapping of a whole file
+typedef struct {
+    const char* data;
+    size_t size;
+} JsonFile;
+
+int JsonOpenFile(JsonFile* file, const char* path);
+void JsonCloseFile(JsonFile* file);
+
+void JsonInit(JsonReader* r, const char* data, size_t size);
+
+// type of the next value without consuming it
+JsonType JsonPeek(JsonReader* r);
+
+// Objects: JsonBeginObject then loop while JsonNextKey returns 1, reading or
+// skipping exactly one value per key. Returns 0 once the closing '}' is consumed
+int JsonBeginObject(JsonReader* r);
+int JsonNextKey(JsonReader* r, JsonString* key);
+
+// Arrays: JsonBeginArray then loop while JsonNextElement returns 1.
+// Members must be separated by commas, a missing one fails the reader
+int JsonBeginArray(JsonReader* r);
+int JsonNextElement(JsonReader* r);
+
+// number of elements in the array at the cursor, without consuming it
+int JsonCountElements(JsonReader* r);
+
+double JsonReadNumber(JsonReader* r);
+int JsonReadInt(JsonReader* r);
+unsigned int JsonReadUInt(JsonReader* r);  // full 32-bit range for Tiled gids with flip flags
+int JsonReadBool(JsonReader* r);
+int JsonReadString(JsonReader* r, JsonString* out);
+void JsonSkipValue(JsonReader* r);
+
+int JsonStringEquals(JsonString s, const char* text);
+// decodes escapes into out (always NUL terminated), returns the decoded length
+int JsonStringCopy(JsonString s, char* out, int outSize);
+// malloc'd decoded copy
+char* JsonStringDup(JsonString s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,333 +1,871 @@
 #include "tiled_loader.h"
+#include "arena.h"
+#include "asset_workers.h"
 #include "constants.h"
-#include <cjson/cJSON.h>
+#include "map_binary.h"
+#include "map_chunks.h"
+#include "map_collision.h"
+#include "map_objects.h"
+#include "map_render.h"
+#include "tiled_json.h"
+#include "tile_data.h"
+#include "tile_layers.h"
+#include "texture_atlas.h"
+#include "tileset_registry.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
-// read whole file into a string useing cjson
-static char* ReadFile(const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        printf("Failed to open file: %s\n", filename);
-        return NULL;
-    }
-    fseek(file, 0, SEEK_END);
-    long length = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    char* buffer = (char*)malloc(length + 1);
-    if (buffer) {
-        fread(buffer, 1, length, file);
-        buffer[length] = '\0';
-    }
-    fclose(file);
-    return buffer;
+// grow a malloc'd array so index fits, capacity doubles
+static void* GrowArray(void* array, int* capacity, int index, size_t elementSize) {
+    if (index < *capacity)
+        return array;
+    int newCapacity = *capacity ? *capacity * 2 : 4;
+    while (newCapacity <= index) newCapacity *= 2;
+    void* grown = realloc(array, newCapacity * elementSize);
+    if (!grown)
+        return array;
+    *capacity = newCapacity;
+    return grown;
+}
+
+// same for arrays that live in an arena, grows in place when it was the last allocation
+static void* ArenaGrowArray(Arena* arena, void* array, int* capacity, int index, size_t elementSize) {
+    if (index < *capacity)
+        return array;
+    int newCapacity = *capacity ? *capacity * 2 : 4;
+    while (newCapacity <= index) newCapacity *= 2;
+    void* grown = ArenaRealloc(arena, array, *capacity * elementSize, newCapacity * elementSize);
+    if (!grown)
+        return array;
+    *capacity = newCapacity;
+    return grown;
 }
 
-// make Polygon from cJSON array of points at offsetX offsetY
-static Polygon ParsePolygon(cJSON* polygonArray, float offsetX, float offsetY) {
+// make Polygon from a json array of points, written straight into Polygon.points
+static Polygon ParsePolygon(JsonReader* r, Arena* arena) {
     Polygon poly = {0};
-    if (!polygonArray || !cJSON_IsArray(polygonArray))
-        return poly;
-    int count = cJSON_GetArraySize(polygonArray);
-    poly.pointCount = count;
-    poly.points = (Vector2*)malloc(count * sizeof(Vector2));
+    int count = JsonCountElements(r);
+    if (count > 0)
+        poly.points = (Vector2*)ArenaAlloc(arena, count * sizeof(Vector2));
     int i = 0;
-    cJSON* pointItem = NULL;
-    cJSON_ArrayForEach(pointItem, polygonArray) {
-        double x = cJSON_GetObjectItem(pointItem, "x")->valuedouble;
-        double y = cJSON_GetObjectItem(pointItem, "y")->valuedouble;
-        poly.points[i++] = (Vector2){ (float)(x + offsetX), (float)(y + offsetY) };
+    JsonBeginArray(r);
+    while (JsonNextElement(r)) {
+        Vector2 point = {0, 0};
+        JsonString key;
+        JsonBeginObject(r);
+        while (JsonNextKey(r, &key)) {
+            if (JsonStringEquals(key, "x"))
+                point.x = (float)JsonReadNumber(r);
+            else if (JsonStringEquals(key, "y"))
+                point.y = (float)JsonReadNumber(r);
+            else
+                JsonSkipValue(r);
+        }
+        if (i < count)
+            poly.points[i++] = point;
     }
+    poly.pointCount = i;
     return poly;
 }
 
-// make TileCollision from json
-static TileCollision ParseTileCollision(cJSON* tileJSON) {
-    TileCollision collision = {0};
-    cJSON* objectgroup = cJSON_GetObjectItem(tileJSON, "objectgroup");
-    if (!objectgroup)
-        return collision;
-    cJSON* objects = cJSON_GetObjectItem(objectgroup, "objects");
-    if (!objects || !cJSON_IsArray(objects))
-        return collision;
-    int objectCount = cJSON_GetArraySize(objects);
-    collision.polygonCount = objectCount;
-    collision.polygons = (Polygon*)malloc(objectCount * sizeof(Polygon));
+// an object from an object layer, keys come in any order so the
+// object offset is only applied once the whole object is read
+typedef struct {
+    JsonString name;
+    float x;
+    float y;
+    float width;
+    float height;
+    float rotation;
+    unsigned int gid;   // tile objects only, flip flags included
+    int visible;
+    Polygon polygon;
+} TiledObject;
+
+static TiledObject ParseObject(JsonReader* r, Arena* arena) {
+    TiledObject obj = {0};
+    obj.visible = 1;
+    JsonString key;
+    JsonBeginObject(r);
+    while (JsonNextKey(r, &key)) {
+        if (JsonStringEquals(key, "x"))
+            obj.x = (float)JsonReadNumber(r);
+        else if (JsonStringEquals(key, "y"))
+            obj.y = (float)JsonReadNumber(r);
+        else if (JsonStringEquals(key, "width"))
+            obj.width = (float)JsonReadNumber(r);
+        else if (JsonStringEquals(key, "height"))
+            obj.height = (float)JsonReadNumber(r);
+        else if (JsonStringEquals(key, "rotation"))
+            obj.rotation = (float)JsonReadNumber(r);
+        else if (JsonStringEquals(key, "gid"))
+            obj.gid = JsonReadUInt(r);
+        else if (JsonStringEquals(key, "visible") && JsonPeek(r) == JSON_BOOL)
+            obj.visible = JsonReadBool(r);
+        else if (JsonStringEquals(key, "name") && JsonPeek(r) == JSON_STRING)
+            JsonReadString(r, &obj.name);
+        else if ((JsonStringEquals(key, "polygon") || JsonStringEquals(key, "polyline")) &&
+                 !obj.polygon.points && JsonPeek(r) == JSON_ARRAY)
+            obj.polygon = ParsePolygon(r, arena);
+        else
+            JsonSkipValue(r);
+    }
+    for (int i = 0; i < obj.polygon.pointCount; i++) {
+        obj.polygon.points[i].x += obj.x;
+        obj.polygon.points[i].y += obj.y;
+    }
+    return obj;
+}
+
+// reads an "objects" array, returns the count and a malloc'd array in *out
+// (the objects are temporary, their points are already in the arena)
+static int ParseObjects(JsonReader* r, Arena* arena, TiledObject** out) {
+    int count = JsonCountElements(r);
+    *out = count > 0 ? (TiledObject*)malloc(count * sizeof(TiledObject)) : NULL;
     int i = 0;
-    cJSON* objectItem = NULL;
-    cJSON_ArrayForEach(objectItem, objects) {
-        float offsetX = 0, offsetY = 0;
-        cJSON* xItem = cJSON_GetObjectItem(objectItem, "x");
-        cJSON* yItem = cJSON_GetObjectItem(objectItem, "y");
-        if (xItem)
-            offsetX = (float)xItem->valuedouble;
-        if (yItem)
-            offsetY = (float)yItem->valuedouble;
-        cJSON* polygonArray = cJSON_GetObjectItem(objectItem, "polygon");
-        if (!polygonArray)
-            polygonArray = cJSON_GetObjectItem(objectItem, "polyline");
-        if (polygonArray && cJSON_IsArray(polygonArray))
-            collision.polygons[i] = ParsePolygon(polygonArray, offsetX, offsetY);
-        else {
-            collision.polygons[i].points = NULL;
-            collision.polygons[i].pointCount = 0;
+    JsonBeginArray(r);
+    while (JsonNextElement(r)) {
+        TiledObject obj = ParseObject(r, arena);
+        if (i < count)
+            (*out)[i++] = obj;
+    }
+    return i;
+}
+
+// packs a tile's "objectgroup" into out, the objects are parsed into the
+// scratch arena and only their points are kept
+static void ParseTileShapes(JsonReader* r, Arena* scratch, Arena* arena, TileShapes* out) {
+    JsonString key;
+    JsonBeginObject(r);
+    while (JsonNextKey(r, &key)) {
+        if (!JsonStringEquals(key, "objects") || JsonPeek(r) != JSON_ARRAY || out->points) {
+            JsonSkipValue(r);
+            continue;
+        }
+        TiledObject* objects = NULL;
+        int count = ParseObjects(r, scratch, &objects);
+        int pointCount = 0;
+        for (int i = 0; i < count; i++)
+            pointCount += objects[i].polygon.pointCount;
+        if (pointCount > 0) {
+            out->polygonCount = count;
+            out->pointCounts = (int*)ArenaAlloc(arena, count * sizeof(int));
+            out->points = (Vector2*)ArenaAlloc(arena, pointCount * sizeof(Vector2));
+            Vector2* points = out->points;
+            for (int i = 0; i < count; i++) {
+                out->pointCounts[i] = objects[i].polygon.pointCount;
+                if (objects[i].polygon.pointCount > 0)
+                    memcpy(points, objects[i].polygon.points, objects[i].polygon.pointCount * sizeof(Vector2));
+                points += objects[i].polygon.pointCount;
+            }
+        }
+        free(objects);
+        ArenaReset(scratch);
+    }
+}
+
+// a tile's "animation" array, frames go in the tileset arena
+static void ParseTileAnimation(JsonReader* r, Arena* arena, TileAnimation* out) {
+    int capacity = 0;
+    JsonBeginArray(r);
+    while (JsonNextElement(r)) {
+        TileFrame frame = { -1, 0 };
+        JsonString key;
+        JsonBeginObject(r);
+        while (JsonNextKey(r, &key)) {
+            if (JsonStringEquals(key, "tileid"))
+                frame.tileId = JsonReadInt(r);
+            else if (JsonStringEquals(key, "duration"))
+                frame.duration = JsonReadInt(r);
+            else
+                JsonSkipValue(r);
         }
-        i++;
+        out->frames = (TileFrame*)ArenaGrowArray(arena, out->frames, &capacity, out->frameCount, sizeof(TileFrame));
+        if (out->frameCount < capacity)
+            out->frames[out->frameCount++] = frame;
     }
-    return collision;
+}
+
+// by tile id, the earlier entry first when a tile is listed twice
+static int CompareTileAnimations(const void* a, const void* b) {
+    const TileAnimation* aa = (const TileAnimation*)a;
+    const TileAnimation* ab = (const TileAnimation*)b;
+    if (aa->tileId != ab->tileId)
+        return aa->tileId < ab->tileId ? -1 : 1;
+    return aa < ab ? -1 : (aa > ab);
+}
+
+// usable frames only: the tile and every frame inside the tileset, all
+// durations positive
+static int TileAnimationIsValid(const TileAnimation* animation, int tileCount) {
+    if (animation->tileId < 0 || animation->tileId >= tileCount || animation->frameCount <= 0)
+        return 0;
+    for (int i = 0; i < animation->frameCount; i++) {
+        const TileFrame* frame = &animation->frames[i];
+        if (frame->tileId < 0 || frame->tileId >= tileCount || frame->duration <= 0)
+            return 0;
+    }
+    return 1;
+}
+
+// by tile id, the earlier entry first when a tile is listed twice
+static int CompareTileShapes(const void* a, const void* b) {
+    const TileShapes* sa = (const TileShapes*)a;
+    const TileShapes* sb = (const TileShapes*)b;
+    if (sa->tileId != sb->tileId)
+        return sa->tileId < sb->tileId ? -1 : 1;
+    return sa < sb ? -1 : (sa > sb);
 }
 
 static Tileset LoadTileset(const char* tilesetFilename, int firstgid) {
     Tileset ts = {0};
-    char* jsonText = ReadFile(tilesetFilename);
-    if (!jsonText) {
+    JsonFile file;
+    if (!JsonOpenFile(&file, tilesetFilename)) {
         printf("Failed to load tileset file: %s\n", tilesetFilename);
         return ts;
     }
-    cJSON* root = cJSON_Parse(jsonText);
-    free(jsonText);
-    if (!root) {
-        printf("Failed to parse tileset JSON: %s\n", tilesetFilename);
-        return ts;
+    // everything the tileset keeps lives in its own arena (it outlives maps)
+    ts.arena = CreateArena(TILESET_ARENA_BLOCK);
+    // tiles with shapes are packed as they come and sorted at the end,
+    // scratch holds the parsed objects until their points are packed
+    Arena* scratch = CreateArena(0);
+    int shapeCapacity = 0, animationCapacity = 0;
+
+    JsonReader r;
+    JsonString key;
+    JsonInit(&r, file.data, file.size);
+    JsonBeginObject(&r);
+    while (JsonNextKey(&r, &key)) {
+        if (JsonStringEquals(key, "tilewidth"))
+            ts.tileWidth = JsonReadInt(&r);
+        else if (JsonStringEquals(key, "tileheight"))
+            ts.tileHeight = JsonReadInt(&r);
+        else if (JsonStringEquals(key, "tilecount"))
+            ts.tileCount = JsonReadInt(&r);
+        else if (JsonStringEquals(key, "imagewidth"))
+            ts.imageWidth = JsonReadInt(&r);
+        else if (JsonStringEquals(key, "imageheight"))
+            ts.imageHeight = JsonReadInt(&r);
+        else if (JsonStringEquals(key, "image") && JsonPeek(&r) == JSON_STRING) {
+            JsonString image;
+            char rawPath[512];
+            JsonReadString(&r, &image);
+            JsonStringCopy(image, rawPath, sizeof(rawPath));
+            const char* path = rawPath;
+            if (strncmp(path, "../../", 6) == 0)
+                path += 6;
+            ts.imagePath = ArenaStrdup(ts.arena, path);
+        }
+        else if (JsonStringEquals(key, "tiles") && JsonPeek(&r) == JSON_ARRAY) {
+            JsonBeginArray(&r);
+            while (JsonNextElement(&r)) {
+                TileShapes shapes = { .tileId = -1 };
+                TileAnimation animation = { 0 };
+                JsonString tileKey;
+                JsonBeginObject(&r);
+                while (JsonNextKey(&r, &tileKey)) {
+                    if (JsonStringEquals(tileKey, "id"))
+                        shapes.tileId = JsonReadInt(&r);
+                    else if (JsonStringEquals(tileKey, "objectgroup") && JsonPeek(&r) == JSON_OBJECT)
+                        ParseTileShapes(&r, scratch, ts.arena, &shapes);
+                    else if (JsonStringEquals(tileKey, "animation") && JsonPeek(&r) == JSON_ARRAY && !animation.frames)
+                        ParseTileAnimation(&r, ts.arena, &animation);
+                    else
+                        JsonSkipValue(&r);
+                }
+                if (animation.frameCount > 0) {
+                    animation.tileId = shapes.tileId;
+                    ts.animations = (TileAnimation*)ArenaGrowArray(ts.arena, ts.animations, &animationCapacity,
+                                                                   ts.animationCount, sizeof(TileAnimation));
+                    if (ts.animationCount < animationCapacity)
+                        ts.animations[ts.animationCount++] = animation;
+                }
+                if (!shapes.points) continue;
+                ts.shapes = (TileShapes*)ArenaGrowArray(ts.arena, ts.shapes, &shapeCapacity, ts.shapeCount, sizeof(TileShapes));
+                if (ts.shapeCount < shapeCapacity)
+                    ts.shapes[ts.shapeCount++] = shapes;
+            }
+        }
+        else
+            JsonSkipValue(&r);
     }
-    ts.tileWidth  = cJSON_GetObjectItem(root, "tilewidth")->valueint;
-    ts.tileHeight = cJSON_GetObjectItem(root, "tileheight")->valueint;
-    ts.tileCount  = cJSON_GetObjectItem(root, "tilecount")->valueint;
-    ts.imageWidth = cJSON_GetObjectItem(root, "imagewidth")->valueint;
-    ts.imageHeight= cJSON_GetObjectItem(root, "imageheight")->valueint;
-    ts.firstgid   = firstgid;
-    cJSON* imageItem = cJSON_GetObjectItem(root, "image");
-    if (imageItem && imageItem->valuestring) {
-        char imagePath[512];
-        const char* rawPath = imageItem->valuestring;
-        if (strncmp(rawPath, "../../", 6) == 0)
-            rawPath += 6;
-        snprintf(imagePath, sizeof(imagePath), "%s", rawPath);
-        ts.texture = LoadTexture(imagePath);
-    } else {
+    if (r.error)
+        printf("Failed to parse tileset JSON: %s\n", tilesetFilename);
+    if (!ts.imagePath)
         printf("Tileset image not found in %s\n", tilesetFilename);
+    JsonCloseFile(&file);
+
+    ts.firstgid = firstgid;
+    ts.source = ArenaStrdup(ts.arena, tilesetFilename);
+    DestroyArena(scratch);
+    // "tilecount" is not guaranteed to come before "tiles", so ids are only
+    // checked now. Keep one entry per valid id for the binary search
+    if (ts.shapeCount > 0)
+        qsort(ts.shapes, ts.shapeCount, sizeof(TileShapes), CompareTileShapes);
+    int kept = 0;
+    for (int i = 0; i < ts.shapeCount; i++) {
+        const TileShapes* shapes = &ts.shapes[i];
+        if (shapes->tileId < 0 || shapes->tileId >= ts.tileCount) continue;
+        if (kept > 0 && ts.shapes[kept - 1].tileId == shapes->tileId) continue;
+        ts.shapes[kept++] = *shapes;
     }
-    ts.source = strdup(tilesetFilename);
-    ts.collisions = (TileCollision*)calloc(ts.tileCount, sizeof(TileCollision));
-    cJSON* tilesArray = cJSON_GetObjectItem(root, "tiles");
-    if (tilesArray && cJSON_IsArray(tilesArray)) {
-        cJSON* tileEntry = NULL;
-        cJSON_ArrayForEach(tileEntry, tilesArray) {
-            int localID = cJSON_GetObjectItem(tileEntry, "id")->valueint;
-            if (localID >= 0 && localID < ts.tileCount)
-                ts.collisions[localID] = ParseTileCollision(tileEntry);
+    ts.shapeCount = kept;
+    // animations the same way, AnimateMapTiles trusts every frame
+    if (ts.animationCount > 0)
+        qsort(ts.animations, ts.animationCount, sizeof(TileAnimation), CompareTileAnimations);
+    kept = 0;
+    for (int i = 0; i < ts.animationCount; i++) {
+        const TileAnimation* animation = &ts.animations[i];
+        if (!TileAnimationIsValid(animation, ts.tileCount)) {
+            printf("Ignoring invalid animation of tile %d in %s\n", animation->tileId, tilesetFilename);
+            continue;
         }
+        if (kept > 0 && ts.animations[kept - 1].tileId == animation->tileId) continue;
+        ts.animations[kept++] = *animation;
     }
-    cJSON_Delete(root);
+    ts.animationCount = kept;
     return ts;
 }
 
-GameMap LoadGameMap(const char* mapFilePath) {
+// "../Tilesets/GrassHills.tsx" -> "Tiled/Tilesets/GrassHills.tsj"
+static void ResolveTilesetPath(JsonString source, char* tsPath, int size) {
+    char raw[256];
+    JsonStringCopy(source, raw, sizeof(raw));
+    const char* relative = raw;
+    if (strncmp(raw, "../", 3) == 0)
+        relative = raw + 3;
+    if (strncmp(relative, "Tilesets/", 9) == 0)
+        snprintf(tsPath, size, "Tiled/%s", relative);
+    else
+        snprintf(tsPath, size, "Tiled/Tilesets/%s", relative);
+    char* ext = strrchr(tsPath, '.');
+    if (ext && strcmp(ext, ".tsx") == 0)
+        strcpy(ext, ".tsj");
+}
+
+typedef struct {
+    char path[512];
+    int firstgid;
+    Tileset loaded;
+} TilesetLoad;
+
+static void LoadTilesetTask(void* arg) {
+    TilesetLoad* load = (TilesetLoad*)arg;
+    load->loaded = LoadTileset(load->path, load->firstgid);
+}
+
+static void ParseTilesets(JsonReader* r, GameMap* map) {
+    TilesetLoad* loads = NULL;
+    int capacity = 0, loadCapacity = 0;
+    JsonBeginArray(r);
+    while (JsonNextElement(r)) {
+        int firstgid = 0;
+        JsonString source = {0};
+        JsonString key;
+        JsonBeginObject(r);
+        while (JsonNextKey(r, &key)) {
+            if (JsonStringEquals(key, "firstgid"))
+                firstgid = JsonReadInt(r);
+            else if (JsonStringEquals(key, "source") && JsonPeek(r) == JSON_STRING)
+                JsonReadString(r, &source);
+            else
+                JsonSkipValue(r);
+        }
+        if (!source.start) continue;   // embedded tilesets are not supported
+        TilesetLoad* load;
+        loads = (TilesetLoad*)GrowArray(loads, &loadCapacity, map->tilesetCount, sizeof(TilesetLoad));
+        map->tilesets = (Tileset*)ArenaGrowArray(map->arena, map->tilesets, &capacity, map->tilesetCount, sizeof(Tileset));
+        load = &loads[map->tilesetCount++];
+        ResolveTilesetPath(source, load->path, sizeof(load->path));
+        load->firstgid = firstgid;
+        memset(&load->loaded, 0, sizeof(Tileset));
+    }
+
+    // only parse tilesets no other map has loaded yet, all of them at once
+    AssetJob* job = BeginAssetJob();
+    for (int i = 0; i < map->tilesetCount; i++) {
+        Tileset* ts = &map->tilesets[i];
+        if (AcquireSharedTileset(loads[i].path, loads[i].firstgid, ts)) continue;
+        int repeated = 0;
+        for (int j = 0; j < i && !repeated; j++)
+            repeated = strcmp(loads[j].path, loads[i].path) == 0;
+        if (!repeated)
+            QueueAssetTask(job, LoadTilesetTask, &loads[i]);
+        memset(ts, 0, sizeof(Tileset));
+    }
+    FinishAssetJob(job);
+    for (int i = 0; i < map->tilesetCount; i++) {
+        Tileset* ts = &map->tilesets[i];
+        if (ts->source) continue;
+        // a repeat of an earlier entry, or another thread shared it meanwhile
+        if (AcquireSharedTileset(loads[i].path, loads[i].firstgid, ts)) {
+            FreeTilesetData(&loads[i].loaded);
+            continue;
+        }
+        *ts = ShareTileset(loads[i].loaded, loads[i].firstgid);
+    }
+    free(loads);
+}
+
+// raw gids go into a temporary array (freed by ParseLayer), ConvertTileGids
+// turns them into the layer's 16-bit ids once the layer is complete
+static int* ParseTileData(JsonReader* r, int* count) {
+    *count = JsonCountElements(r);
+    int* tiles = (int*)malloc((*count > 0 ? *count : 1) * sizeof(int));
+    if (!tiles) {
+        *count = 0;
+        JsonSkipValue(r);
+        return NULL;
+    }
+    int idx = 0;
+    JsonBeginArray(r);
+    while (JsonNextElement(r)) {
+        unsigned int gid = JsonReadUInt(r);
+        if (idx < *count)
+            tiles[idx++] = (int)gid;
+    }
+    *count = idx;
+    return tiles;
+}
+
+// base64 "data" strings are decoded at the end of the layer, when the
+// size and compression are known, into the same kind of temporary array
+static int* DecodeLayerData(JsonString data, JsonString compression, int width, int height) {
+    int kind = ParseTileCompression(compression.start, compression.length);
+    if (kind < 0) {
+        TraceLog(LOG_WARNING, "Unsupported tile layer compression \"%.*s\"", compression.length, compression.start);
+        return NULL;
+    }
+    if (width <= 0 || height <= 0)
+        return NULL;
+    int* tiles = (int*)malloc(width * height * sizeof(int));
+    if (!tiles || !DecodeTileData(data.start, data.length, (TileCompression)kind, tiles, width * height)) {
+        TraceLog(LOG_WARNING, "Failed to decode %dx%d tile layer data", width, height);
+        free(tiles);
+        return NULL;
+    }
+    return tiles;
+}
+
+// Infinite layers: only remembers where each chunk's data is in the mapped
+// file, decoding happens later in LoadTileChunk when the camera gets close
+static int ParseChunks(JsonReader* r, Arena* arena, TileChunk** out) {
+    int count = JsonCountElements(r);
+    *out = count > 0 ? (TileChunk*)ArenaAllocZero(arena, count * sizeof(TileChunk)) : NULL;
+    int i = 0;
+    JsonBeginArray(r);
+    while (JsonNextElement(r)) {
+        TileChunk chunk = {0};
+        JsonString key;
+        JsonBeginObject(r);
+        while (JsonNextKey(r, &key)) {
+            if (JsonStringEquals(key, "x"))
+                chunk.x = JsonReadInt(r);
+            else if (JsonStringEquals(key, "y"))
+                chunk.y = JsonReadInt(r);
+            else if (JsonStringEquals(key, "width"))
+                chunk.width = JsonReadInt(r);
+            else if (JsonStringEquals(key, "height"))
+                chunk.height = JsonReadInt(r);
+            else if (JsonStringEquals(key, "data") && JsonPeek(r) == JSON_STRING) {
+                JsonString data;
+                JsonReadString(r, &data);
+                chunk.source = data.start;
+                chunk.sourceLength = data.length;
+                chunk.encoding = TILE_CHUNK_BASE64;
+            }
+            else if (JsonStringEquals(key, "data") && JsonPeek(r) == JSON_ARRAY) {
+                const char* start = r->cur;
+                JsonSkipValue(r);
+                chunk.source = start;
+                chunk.sourceLength = (int)(r->cur - start);
+                chunk.encoding = TILE_CHUNK_CSV;
+            }
+            else
+                JsonSkipValue(r);
+        }
+        if (i < count && chunk.source)
+            (*out)[i++] = chunk;
+    }
+    return i;
+}
+
+typedef struct {
+    int tileLayerCapacity;
+    int collisionCapacity;
+    int transitionCapacity;
+    int tileObjectCapacity;
+} MapCapacity;
+
+static void AddTransitions(GameMap* map, MapCapacity* cap, TiledObject* objects, int count) {
+    for (int i = 0; i < count; i++) {
+        TiledObject* obj = &objects[i];
+        // Expected format: "targetMap:tileX,tileY" (e.g., "smallFlowerMap:0,10")
+        char name[512];
+        char targetMap[256] = {0};
+        float tileX = 0, tileY = 0;
+        JsonStringCopy(obj->name, name, sizeof(name));
+        if (!obj->name.start || sscanf(name, "%255[^:]:%f,%f", targetMap, &tileX, &tileY) != 3)
+            continue;
+        map->transitions = (MapTransition*)ArenaGrowArray(map->arena, map->transitions, &cap->transitionCapacity,
+                                                          map->transitionCount, sizeof(MapTransition));
+        MapTransition* tr = &map->transitions[map->transitionCount++];
+        tr->targetMap = ArenaStrdup(map->arena, targetMap);
+        tr->startX = tileX * BASE_TILE_SIZE * PIXEL_SCALE;
+        tr->startY = tileY * BASE_TILE_SIZE * PIXEL_SCALE;
+        tr->triggerArea = obj->polygon;
+        TraceLog(LOG_INFO, "Parsed transition: targetMap = %s, tile coords = (%.2f, %.2f) -> pixel coords = (%.2f, %.2f)",
+            targetMap, tileX, tileY, tr->startX, tr->startY);
+    }
+}
+
+static void AddCollisions(GameMap* map, MapCapacity* cap, TiledObject* objects, int count) {
+    for (int i = 0; i < count; i++) {
+        map->collisionLayer.polygons = (Polygon*)ArenaGrowArray(map->arena, map->collisionLayer.polygons, &cap->collisionCapacity,
+                                                                map->collisionLayer.count, sizeof(Polygon));
+        map->collisionLayer.polygons[map->collisionLayer.count++] = objects[i].polygon;
+    }
+}
+
+// gid objects become TileObjects, the rest of the layer (shapes, points) is
+// not used. BuildTileObjectGrid buckets them once the whole map is read
+static void AddTileObjects(GameMap* map, MapCapacity* cap, TiledObject* objects, int count) {
+    int rotated = 0;
+    for (int i = 0; i < count; i++) {
+        TiledObject* obj = &objects[i];
+        if (!obj->gid || !obj->visible) continue;
+        TileId tile;
+        unsigned char flip;
+        if (ConvertTileGids((const int*)&obj->gid, 1, &tile, &flip) > 0)
+            TraceLog(LOG_WARNING, "Tile object id %u is past %d, dropped", (obj->gid & TILE_GID_MASK) - 1, TILE_NONE - 1);
+        if (tile == TILE_NONE) continue;
+        // keeps the bucket grid math in range, no map is this big
+        if (!(fabsf(obj->x) < 1e7f && fabsf(obj->y) < 1e7f && obj->width < 1e7f && obj->height < 1e7f)) continue;
+        rotated += obj->rotation != 0.0f;
+        map->tileObjects = (TileObject*)ArenaGrowArray(map->arena, map->tileObjects, &cap->tileObjectCapacity,
+                                                       map->tileObjectCount, sizeof(TileObject));
+        TileObject* out = &map->tileObjects[map->tileObjectCount++];
+        memset(out, 0, sizeof(TileObject));
+        out->x = obj->x;
+        out->y = obj->y;
+        // objects saved without a size get one map tile
+        out->width = obj->width > 0.0f ? obj->width : (float)BASE_TILE_SIZE;
+        out->height = obj->height > 0.0f ? obj->height : (float)BASE_TILE_SIZE;
+        out->tile = tile;
+        out->flip = flip & (TILE_FLIP_HORIZONTAL | TILE_FLIP_VERTICAL);
+    }
+    if (rotated > 0)
+        TraceLog(LOG_WARNING, "%d rotated tile objects, they are drawn upright", rotated);
+}
+
+static void ParseLayer(JsonReader* r, GameMap* map, MapCapacity* cap) {
+    JsonString type = {0}, name = {0}, key;
+    JsonString encodedData = {0}, compression = {0};
+    int width = 0, height = 0;
+    int startX = 0, startY = 0;
+    int* tiles = NULL;
+    int tileCount = 0;
+    TileChunk* chunks = NULL;
+    int chunkCount = 0;
+    TiledObject* objects = NULL;
+    int objectCount = 0;
+
+    JsonBeginObject(r);
+    while (JsonNextKey(r, &key)) {
+        if (JsonStringEquals(key, "type") && JsonPeek(r) == JSON_STRING)
+            JsonReadString(r, &type);
+        else if (JsonStringEquals(key, "name") && JsonPeek(r) == JSON_STRING)
+            JsonReadString(r, &name);
+        else if (JsonStringEquals(key, "width"))
+            width = JsonReadInt(r);
+        else if (JsonStringEquals(key, "height"))
+            height = JsonReadInt(r);
+        else if (JsonStringEquals(key, "data") && JsonPeek(r) == JSON_ARRAY && !tiles)
+            tiles = ParseTileData(r, &tileCount);
+        else if (JsonStringEquals(key, "data") && JsonPeek(r) == JSON_STRING)
+            JsonReadString(r, &encodedData);   // "encoding": "base64", decoded below
+        else if (JsonStringEquals(key, "compression") && JsonPeek(r) == JSON_STRING)
+            JsonReadString(r, &compression);
+        else if (JsonStringEquals(key, "chunks") && JsonPeek(r) == JSON_ARRAY && !chunks)
+            chunkCount = ParseChunks(r, map->arena, &chunks);
+        else if (JsonStringEquals(key, "startx"))
+            startX = JsonReadInt(r);
+        else if (JsonStringEquals(key, "starty"))
+            startY = JsonReadInt(r);
+        else if (JsonStringEquals(key, "objects") && JsonPeek(r) == JSON_ARRAY && !objects)
+            objectCount = ParseObjects(r, map->arena, &objects);
+        else
+            JsonSkipValue(r);
+    }
+
+    if (JsonStringEquals(type, "tilelayer") && !tiles && encodedData.start) {
+        tiles = DecodeLayerData(encodedData, compression, width, height);
+        tileCount = tiles ? width * height : 0;
+    }
+
+    if (JsonStringEquals(type, "tilelayer") && tiles) {
+        map->tileLayers = (TileLayer*)ArenaGrowArray(map->arena, map->tileLayers, &cap->tileLayerCapacity,
+                                                     map->tileLayerCount, sizeof(TileLayer));
+        TileLayer* layer = &map->tileLayers[map->tileLayerCount++];
+        memset(layer, 0, sizeof(TileLayer));
+        layer->width = width;
+        layer->height = height;
+        // keep the layer width*height even if the data array was short
+        int cells = tileCount;
+        if (tileCount != width * height && width > 0 && height > 0) {
+            TraceLog(LOG_WARNING, "Tile layer has %d tiles, expected %d", tileCount, width * height);
+            cells = width * height;
+            if (tileCount > cells) tileCount = cells;
+        }
+        layer->tiles = (TileId*)ArenaAlloc(map->arena, (cells > 0 ? cells : 1) * sizeof(TileId));
+        layer->tileCount = cells;
+        if (TileGidsHaveFlags(tiles, tileCount))
+            layer->flips = (unsigned char*)ArenaAllocZero(map->arena, cells > 0 ? cells : 1);
+        if (ConvertTileGids(tiles, tileCount, layer->tiles, layer->flips) > 0)
+            TraceLog(LOG_WARNING, "Tile layer has tile ids past %d, dropped", TILE_NONE - 1);
+        for (int i = tileCount; i < cells; i++)
+            layer->tiles[i] = TILE_NONE;
+    } else if (JsonStringEquals(type, "tilelayer") && chunks) {
+        int kind = ParseTileCompression(compression.start, compression.length);
+        if (kind < 0) {
+            TraceLog(LOG_WARNING, "Unsupported tile layer compression \"%.*s\"", compression.length, compression.start);
+            kind = TILE_COMPRESSION_NONE;
+        }
+        for (int i = 0; i < chunkCount; i++)
+            chunks[i].compression = (unsigned char)kind;
+        map->tileLayers = (TileLayer*)ArenaGrowArray(map->arena, map->tileLayers, &cap->tileLayerCapacity,
+                                                     map->tileLayerCount, sizeof(TileLayer));
+        TileLayer* layer = &map->tileLayers[map->tileLayerCount++];
+        memset(layer, 0, sizeof(TileLayer));
+        layer->width = width;
+        layer->height = height;
+        layer->originX = startX;
+        layer->originY = startY;
+        layer->chunks = chunks;
+        layer->chunkCount = chunkCount;
+        chunks = NULL;
+        BuildChunkGrid(map->arena, layer);
+    } else if (JsonStringEquals(type, "objectgroup") && JsonStringEquals(name, "MapTransition")) {
+        AddTransitions(map, cap, objects, objectCount);
+        objectCount = 0;
+    } else if (JsonStringEquals(type, "objectgroup") && JsonStringEquals(name, "Collision")) {
+        AddCollisions(map, cap, objects, objectCount);
+        objectCount = 0;
+    } else if (JsonStringEquals(type, "objectgroup")) {
+        AddTileObjects(map, cap, objects, objectCount);
+    }
+
+    // anything not claimed above (groups, image layers...) is dropped,
+    // its arena memory goes with the map
+    free(tiles);
+    free(objects);
+}
+
+GameMap LoadGameMapData(const char* mapFilePath) {
     GameMap map = {0};
-    char* jsonText = ReadFile(mapFilePath);
-    if (!jsonText) {
+    JsonFile file;
+    if (!JsonOpenFile(&file, mapFilePath)) {
         printf("Failed to load map file: %s\n", mapFilePath);
         return map;
     }
-    cJSON* root = cJSON_Parse(jsonText);
-    free(jsonText);
-    if (!root) {
+
+    MapCapacity cap = {0};
+    map.arena = CreateArena(MAP_ARENA_BLOCK);
+    JsonReader r;
+    JsonString key;
+    JsonInit(&r, file.data, file.size);
+    JsonBeginObject(&r);
+    while (JsonNextKey(&r, &key)) {
+        if (JsonStringEquals(key, "width"))
+            map.mapWidth = JsonReadInt(&r);
+        else if (JsonStringEquals(key, "height"))
+            map.mapHeight = JsonReadInt(&r);
+        else if (JsonStringEquals(key, "infinite") && JsonPeek(&r) == JSON_BOOL)
+            map.infinite = JsonReadBool(&r);
+        else if (JsonStringEquals(key, "tilesets") && JsonPeek(&r) == JSON_ARRAY)
+            ParseTilesets(&r, &map);
+        else if (JsonStringEquals(key, "layers") && JsonPeek(&r) == JSON_ARRAY) {
+            JsonBeginArray(&r);
+            while (JsonNextElement(&r))
+                ParseLayer(&r, &map, &cap);
+        }
+        else
+            JsonSkipValue(&r);
+    }
+    // chunks decode straight out of the file, so it stays mapped with the map
+    int hasChunks = 0;
+    for (int i = 0; i < map.tileLayerCount; i++)
+        hasChunks |= map.tileLayers[i].chunkCount > 0;
+    if (hasChunks) {
+        map.source = file.data;
+        map.sourceSize = file.size;
+        map.chunkBudget = CHUNK_MEMORY_BUDGET;
+    } else {
+        JsonCloseFile(&file);
+    }
+
+    if (r.error) {
         printf("Error parsing map JSON: %s\n", mapFilePath);
-        return map;
+        UnloadGameMap(&map);
+        return (GameMap){0};
     }
 
-    // Basic map properties
-    map.mapWidth   = cJSON_GetObjectItem(root, "width")->valueint;
-    map.mapHeight  = cJSON_GetObjectItem(root, "height")->valueint;
     // force BASE_TILE_SIZE
     map.tileWidth  = BASE_TILE_SIZE;
     map.tileHeight = BASE_TILE_SIZE;
-
-    //Load Tilesets
-    cJSON* tsArray = cJSON_GetObjectItem(root, "tilesets");
-    if (tsArray && cJSON_IsArray(tsArray)) {
-        int tsCount = cJSON_GetArraySize(tsArray);
-        map.tilesetCount = tsCount;
-        map.tilesets = (Tileset*)malloc(tsCount * sizeof(Tileset));
-        int i = 0;
-        cJSON* tsEntry = NULL;
-        cJSON_ArrayForEach(tsEntry, tsArray) {
-            int firstgid = cJSON_GetObjectItem(tsEntry, "firstgid")->valueint;
-            char* source = cJSON_GetObjectItem(tsEntry, "source")->valuestring;
-            if (source) {
-                char* relative = source;
-                if (strncmp(source, "../", 3) == 0)
-                    relative = source + 3;
-                char tsPath[512];
-                if (strncmp(relative, "Tilesets/", 9) == 0)
-                    snprintf(tsPath, sizeof(tsPath), "Tiled/%s", relative);
-                else
-                    snprintf(tsPath, sizeof(tsPath), "Tiled/Tilesets/%s", relative);
-                char* ext = strrchr(tsPath, '.');
-                if (ext && strcmp(ext, ".tsx") == 0)
-                    strcpy(ext, ".tsj");
-                map.tilesets[i++] = LoadTileset(tsPath, firstgid);
-            }
+    // layers without their own size (the map size may come after the layers)
+    for (int i = 0; i < map.tileLayerCount; i++) {
+        if (!map.tileLayers[i].chunks && (map.tileLayers[i].width <= 0 || map.tileLayers[i].height <= 0)) {
+            map.tileLayers[i].width = map.mapWidth;
+            map.tileLayers[i].height = map.mapHeight;
         }
+        // sizes are final now, mostly empty layers go sparse
+        CompactTileLayer(map.arena, &map.tileLayers[i]);
     }
+    BuildTileObjectGrid(&map);
+    return map;
+}
 
-    //count num tile layers and map transitions
-    int tileLayerCount = 0, transitionCount = 0;
-    cJSON* layers = cJSON_GetObjectItem(root, "layers");
-    cJSON* layerCounter = layers ? layers->child : NULL;
-    while (layerCounter) {
-        char* layerType = cJSON_GetObjectItem(layerCounter, "type")->valuestring;
-        char* layerName = cJSON_GetObjectItem(layerCounter, "name")->valuestring;
-        if (strcmp(layerType, "tilelayer") == 0) {
-            tileLayerCount++;
-        } else if (strcmp(layerType, "objectgroup") == 0 && strcmp(layerName, "MapTransition") == 0) {
-            transitionCount++;
-        }
-        layerCounter = layerCounter->next;
-    }
-    //malloc
-    map.tileLayerCount = tileLayerCount;
-    map.tileLayers = (TileLayer*)malloc(tileLayerCount * sizeof(TileLayer));
-    map.transitionCount = transitionCount;
-    map.transitions = (MapTransition*)malloc(transitionCount * sizeof(MapTransition));
-    map.collisionLayer.count = 0;
-    map.collisionLayer.polygons = NULL;
-
-    // Process layers after count with fresh iterator
-    int tIdx = 0, trIdx = 0;
-    cJSON* layerIter = layers ? layers->child : NULL;
-    while (layerIter) {
-        char* layerType = cJSON_GetObjectItem(layerIter, "type")->valuestring;
-        char* layerName = cJSON_GetObjectItem(layerIter, "name")->valuestring;
-        if (strcmp(layerType, "tilelayer") == 0) {
-            cJSON* data = cJSON_GetObjectItem(layerIter, "data");
-            if (!data || !cJSON_IsArray(data)) {
-                layerIter = layerIter->next;
-                continue;
-            }
-            map.tileLayers[tIdx].width = map.mapWidth;
-            map.tileLayers[tIdx].height = map.mapHeight;
-            map.tileLayers[tIdx].tiles = (int*)malloc(map.mapWidth * map.mapHeight * sizeof(int));
-            int idx = 0;
-            cJSON* tileVal = NULL;
-            cJSON_ArrayForEach(tileVal, data) {
-                int id = tileVal->valueint;
-                map.tileLayers[tIdx].tiles[idx++] = (id > 0) ? id - 1 : -1;
-            }
-            tIdx++;
-        }
-        else if (strcmp(layerType, "objectgroup") == 0) {
-            // Map Transitions
-            if (strcmp(layerName, "MapTransition") == 0) {
-                cJSON* objects = cJSON_GetObjectItem(layerIter, "objects");
-                if (!objects || !cJSON_IsArray(objects)) {
-                    layerIter = layerIter->next;
-                    continue;
-                }
-                cJSON* obj;
-                cJSON_ArrayForEach(obj, objects) {
-                    float offsetX = 0, offsetY = 0;
-                    cJSON* xItem = cJSON_GetObjectItem(obj, "x");
-                    cJSON* yItem = cJSON_GetObjectItem(obj, "y");
-                    if (xItem) offsetX = (float)xItem->valuedouble;
-                    if (yItem) offsetY = (float)yItem->valuedouble;
-                    cJSON* nameItem = cJSON_GetObjectItem(obj, "name");
-                    if (!nameItem) continue;
-                    char* name = nameItem->valuestring;
-                    // Expected format: "targetMap:tileX,tileY" (e.g., "smallFlowerMap:0,10")
-                    char targetMap[256] = {0};
-                    float tileX = 0, tileY = 0;
-                    if (sscanf(name, "%[^:]:%f,%f", targetMap, &tileX, &tileY) == 3) {
-                        map.transitions[trIdx].targetMap = strdup(targetMap);
-                        map.transitions[trIdx].startX = tileX * BASE_TILE_SIZE * PIXEL_SCALE;
-                        map.transitions[trIdx].startY = tileY * BASE_TILE_SIZE * PIXEL_SCALE;
-                        TraceLog(LOG_INFO, "Parsed transition: targetMap = %s, tile coords = (%.2f, %.2f) -> pixel coords = (%.2f, %.2f)",
-                            targetMap, tileX, tileY, map.transitions[trIdx].startX, map.transitions[trIdx].startY);
-                    } else {
-                        continue;
-                    }
-                    cJSON* polygonArray = cJSON_GetObjectItem(obj, "polygon");
-                    if (!polygonArray)
-                        polygonArray = cJSON_GetObjectItem(obj, "polyline");
-                    if (polygonArray && cJSON_IsArray(polygonArray))
-                        map.transitions[trIdx].triggerArea = ParsePolygon(polygonArray, offsetX, offsetY);
-                    else {
-                        map.transitions[trIdx].triggerArea.points = NULL;
-                        map.transitions[trIdx].triggerArea.pointCount = 0;
-                    }
-                    trIdx++;
-                }
-            }
-            // Collision Objects
-            else if (strcmp(layerName, "Collision") == 0) {
-                cJSON* objects = cJSON_GetObjectItem(layerIter, "objects");
-                if (!objects || !cJSON_IsArray(objects)) {
-                    layerIter = layerIter->next;
-                    continue;
-                }
-                int count = cJSON_GetArraySize(objects);
-                map.collisionLayer.count = count;
-                map.collisionLayer.polygons = (Polygon*)malloc(count * sizeof(Polygon));
-                int i = 0;
-                cJSON* obj;
-                cJSON_ArrayForEach(obj, objects) {
-                    float offsetX = 0, offsetY = 0;
-                    cJSON* xItem = cJSON_GetObjectItem(obj, "x");
-                    cJSON* yItem = cJSON_GetObjectItem(obj, "y");
-                    if (xItem) offsetX = (float)xItem->valuedouble;
-                    if (yItem) offsetY = (float)yItem->valuedouble;
-                    cJSON* polygonArray = cJSON_GetObjectItem(obj, "polygon");
-                    if (!polygonArray)
-                        polygonArray = cJSON_GetObjectItem(obj, "polyline");
-                    if (polygonArray && cJSON_IsArray(polygonArray))
-                        map.collisionLayer.polygons[i] = ParsePolygon(polygonArray, offsetX, offsetY);
-                    else {
-                        map.collisionLayer.polygons[i].points = NULL;
-                        map.collisionLayer.polygons[i].pointCount = 0;
-                    }
-                    i++;
-                }
+// Animated tiles are drawTable entries AnimateMapTiles rewrites, each frame
+// is a copy of the static entry of the tile it shows
+static void BuildAnimatedTiles(GameMap* map) {
+    map->animatedTileCount = 0;
+    map->tileAnimations = NULL;
+    int count = 0;
+    for (int i = 0; i < map->tilesetCount; i++)
+        count += map->tilesets[i].animationCount;
+    if (count == 0) return;
+    map->animatedTiles = (AnimatedTile*)ArenaAllocZero(map->arena, count * sizeof(AnimatedTile));
+    map->tileAnimations = (int*)ArenaAlloc(map->arena, map->drawTableSize * sizeof(int));
+    if (!map->animatedTiles || !map->tileAnimations) {
+        map->tileAnimations = NULL;
+        return;
+    }
+    for (int i = 0; i < map->drawTableSize; i++)
+        map->tileAnimations[i] = -1;
+
+    // frames come from the static table, so fill them all before any entry changes
+    for (int i = 0; i < map->tilesetCount; i++) {
+        const Tileset* ts = &map->tilesets[i];
+        if (ts->firstgid < 1) continue;
+        for (int a = 0; a < ts->animationCount; a++) {
+            const TileAnimation* animation = &ts->animations[a];
+            int tile = ts->firstgid - 1 + animation->tileId;
+            if (map->tileAnimations[tile] >= 0) continue;
+            AnimatedTile* animated = &map->animatedTiles[map->animatedTileCount];
+            animated->frames = (TileDraw*)ArenaAlloc(map->arena, animation->frameCount * sizeof(TileDraw));
+            animated->frameEnds = (int*)ArenaAlloc(map->arena, animation->frameCount * sizeof(int));
+            if (!animated->frames || !animated->frameEnds) continue;
+            int end = 0;
+            for (int f = 0; f < animation->frameCount; f++) {
+                animated->frames[f] = map->drawTable[ts->firstgid - 1 + animation->frames[f].tileId];
+                end += animation->frames[f].duration;
+                animated->frameEnds[f] = end;
             }
+            animated->tile = tile;
+            animated->frameCount = animation->frameCount;
+            map->tileAnimations[tile] = map->animatedTileCount++;
         }
-        layerIter = layerIter->next;
     }
-
-    cJSON_Delete(root);
-    return map;
+    for (int i = 0; i < map->animatedTileCount; i++) {
+        AnimatedTile* animated = &map->animatedTiles[i];
+        animated->current = 0;
+        map->drawTable[animated->tile] = animated->frames[0];
+    }
 }
 
-void UnloadGameMap(GameMap* map) {
-    int i, t, p;
-    for (i = 0; i < map->tilesetCount; i++) {
-        UnloadTexture(map->tilesets[i].texture);
-        free(map->tilesets[i].source);
-        for (t = 0; t < map->tilesets[i].tileCount; t++) {
-            TileCollision* tc = &map->tilesets[i].collisions[t];
-            for (p = 0; p < tc->polygonCount; p++) {
-                free(tc->polygons[p].points);
-            }
-            free(tc->polygons);
+// One record per tile id, so drawing a tile is a single table load instead
+// of a search over the tilesets. Later tilesets win where ranges overlap,
+// the same as the old lookup
+static void BuildTileDrawTable(GameMap* map) {
+    if (!map->arena) return;   // failed load
+    int size = 0;
+    for (int i = 0; i < map->tilesetCount; i++) {
+        const Tileset* ts = &map->tilesets[i];
+        if (ts->firstgid - 1 + ts->tileCount > size)
+            size = ts->firstgid - 1 + ts->tileCount;
+    }
+    map->drawTableSize = 0;
+    map->drawTable = (TileDraw*)ArenaAllocZero(map->arena, (size > 0 ? size : 1) * sizeof(TileDraw));
+    if (!map->drawTable) return;
+    map->drawTableSize = size;
+    for (int i = 0; i < map->tilesetCount; i++) {
+        const Tileset* ts = &map->tilesets[i];
+        if (ts->texture.id == 0 || ts->tileWidth <= 0 || ts->tileHeight <= 0) continue;
+        // tiles of a packed tileset are looked up on the atlas page
+        const AtlasImage* atlas = FindAtlasImage(ts->imagePath);
+        if (atlas && atlas->texture.id != ts->texture.id)
+            atlas = NULL;
+        int columns = (atlas ? atlas->width : ts->texture.width) / ts->tileWidth;
+        if (columns <= 0 || ts->firstgid < 1) continue;
+        for (int local = 0; local < ts->tileCount; local++) {
+            TileDraw* draw = &map->drawTable[ts->firstgid - 1 + local];
+            Rectangle source = {
+                (float)((local % columns) * ts->tileWidth),
+                (float)((local / columns) * ts->tileHeight),
+                (float)ts->tileWidth,
+                (float)ts->tileHeight
+            };
+            // trimmed off tiles are empty, their texture stays 0
+            if (atlas && !MapAtlasRect(atlas, &source, NULL))
+                continue;
+            draw->texture = ts->texture;
+            draw->source = source;
         }
-        free(map->tilesets[i].collisions);
     }
-    free(map->tilesets);
+    BuildAnimatedTiles(map);
+}
 
-    for (i = 0; i < map->tileLayerCount; i++) {
-        free(map->tileLayers[i].tiles);
+void LoadGameMapTextures(GameMap* map) {
+    // decode on the workers, upload here in one go
+    Image* images = DecodeTilesetImages(map->tilesets, map->tilesetCount);
+    for (int i = 0; i < map->tilesetCount; i++) {
+        if (images && images[i].data)
+            UploadSharedTilesetTexture(&map->tilesets[i], images[i]);
+        else
+            LoadSharedTilesetTexture(&map->tilesets[i]);
     }
-    free(map->tileLayers);
+    free(images);
+    BuildTileDrawTable(map);
+}
 
-    //collision layer
-    for (i = 0; i < map->collisionLayer.count; i++) {
-        free(map->collisionLayer.polygons[i].points);
+GameMap LoadGameMapWithoutTextures(const char* mapFilePath) {
+    GameMap map = {0};
+    char compiledPath[512];
+    GetCompiledMapPath(mapFilePath, compiledPath, sizeof(compiledPath));
+    if (!LoadMapBinary(compiledPath, mapFilePath, &map)) {
+        TraceLog(LOG_INFO, "No up to date compiled map for %s, parsing JSON", mapFilePath);
+        map = LoadGameMapData(mapFilePath);
     }
-    free(map->collisionLayer.polygons);
+    BuildMapCollision(&map);
+    return map;
+}
+
+GameMap LoadGameMap(const char* mapFilePath) {
+    GameMap map = LoadGameMapWithoutTextures(mapFilePath);
+    LoadGameMapTextures(&map);
+    return map;
+}
 
-    //map transitions.
-    for (i = 0; i < map->transitionCount; i++) {
-        free(map->transitions[i].targetMap);
-        free(map->transitions[i].triggerArea.points);
+void UnloadGameMap(GameMap* map) {
+    int i;
+    UnloadMapBake(map);
+    UnloadMapChunks(map);
+    if (map->source) {
+        JsonFile file = { map->source, map->sourceSize };
+        JsonCloseFile(&file);
+        map->source = NULL;
+    }
+    if (map->blob) {
+        UnloadMapBinary(map);
+        return;
     }
-    free(map->transitions);
+    // tilesets stay in the registry for the next map that uses them
+    for (i = 0; i < map->tilesetCount; i++)
+        ReleaseSharedTileset(&map->tilesets[i]);
+    // everything else the map allocated goes in one go
+    DestroyArena(map->arena);
+    map->arena = NULL;
 }
@@ -2,6 +2,10 @@
 #define TILED_LOADER_H
 
 #include "raylib.h"
+#include "arena.h"
+#include "tile_data.h"
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,23 +22,92 @@ typedef struct {
     int polygonCount;
 } TileCollision;
 
+// a tile's collision shapes as loaded, every polygon's points back to back.
+// Turned into a TileCollision the first time GetTileCollision asks for it
+typedef struct {
+    int tileId;                // local id in the tileset
+    int polygonCount;
+    int* pointCounts;          // one per polygon
+    Vector2* points;
+    TileCollision* expanded;   // NULL until queried
+} TileShapes;
+
+// Tiled "animation": the tile cycles through other tiles of its tileset
+typedef struct {
+    int tileId;     // local id shown during this frame
+    int duration;   // ms
+} TileFrame;
+
+typedef struct {
+    int tileId;          // local id of the animated tile
+    TileFrame* frames;
+    int frameCount;
+} TileAnimation;
+
 // loaded from Tiled JSON
 typedef struct {
     int firstgid;// Global ID for where this tileset starts
     char* source;//filename "GrassHills.tsj"
+    char* imagePath;//"SproutLandsPack/Tilesets/Hills.png"
     Texture2D texture;// Loaded texture for the tileset image
     int tileWidth;//(from tileset)
     int tileHeight;//(from tileset)
     int imageWidth;//entire image
     int imageHeight;
     int tileCount;// Num of tiles in tileset
-    TileCollision* collisions; //uses Collision object level
+    TileShapes* shapes; // only tiles with collision shapes, sorted by tileId
+    int shapeCount;
+    TileAnimation* animations; // sorted by tileId
+    int animationCount;
+    Arena* arena; // owns source, imagePath, shapes and animations (tileset_registry.h)
 } Tileset;
 
+// where a chunk's tile data lives until it is decoded (infinite maps)
+typedef enum {
+    TILE_CHUNK_CSV = 0,    // json array text in the mapped .tmj
+    TILE_CHUNK_BASE64,     // base64 string in the mapped .tmj
+    TILE_CHUNK_RAW         // already decoded TileIds in a compiled .tmb
+} TileChunkEncoding;
+
+// one piece of an infinite map layer, decoded while near the camera
+typedef struct {
+    int x, y;              // top-left tile
+    int width, height;     // in tiles
+    const char* source;    // encoded data inside the mapped file
+    int sourceLength;
+    unsigned char encoding;    // TileChunkEncoding
+    unsigned char compression; // TileCompression for base64 chunks
+    const unsigned char* sourceFlips; // TILE_CHUNK_RAW only
+    TileId* tiles;         // NULL while not resident, every cell row by row
+    unsigned char* flips;
+    unsigned int lastUsed; // map->chunkFrame when last needed
+    struct ChunkCollision* collision; // its tile shapes while resident, NULL when it has none
+} TileChunk;
+
+// a stretch of non empty cells in one row of a sparse layer (tile_layers.h)
+typedef struct {
+    unsigned short x;      // first cell
+    unsigned short length;
+    unsigned int first;    // its first cell in TileLayer.tiles
+} TileRun;
+
 typedef struct {
     int width;
     int height;
-    int* tiles;//array of tile IDs converted 0-based -1 indicates no tile
+    TileId* tiles;//index into GameMap.drawTable, TILE_NONE for no tile. Every cell row by row, or only the cells of runs
+    unsigned char* flips;//per tile TILE_FLIP_* flags (tile_data.h), same order as tiles, NULL when nothing is flipped
+    int tileCount;//entries in tiles (and flips)
+    // sparse layers only (rowRuns is NULL for dense ones), see tile_layers.h
+    TileRun* runs;//sorted by row then x
+    unsigned int* rowRuns;//height + 1 entries, the runs of row y are [rowRuns[y], rowRuns[y + 1])
+    // infinite maps only (tiles is NULL), see map_chunks.h
+    int originX, originY;//top-left tile of the layer bounds, can be negative
+    TileChunk* chunks;
+    int chunkCount;
+    int chunkWidth, chunkHeight;//every chunk in a layer has the same size
+    int gridX, gridY;//chunk coordinate of chunkGrid[0]
+    int gridWidth, gridHeight;
+    int* chunkGrid;//chunk index per grid cell, -1 where there is no chunk
 } TileLayer;
 
 //from object layer collisions
@@ -43,6 +116,82 @@ typedef struct {
     int count;
 } CollisionLayer;
 
+// a node of the bounding volume hierarchy over a map's polygons
+typedef struct {
+    Rectangle bounds;     // of every polygon below it
+    int first;            // leaf: first entry in CollisionShapes.order, inner: right child (left is the next node)
+    int count;            // leaf: polygons in it, 0 for inner nodes
+} CollisionNode;
+
+// polygons copied to world space once per map, see map_collision.h
+typedef struct {
+    float* xs;            // every polygon's points back to back, in world pixels
+    float* ys;
+    int* starts;          // count + 1, polygon i is points [starts[i], starts[i + 1])
+    Rectangle* bounds;    // per polygon
+    int count;
+    // every polygon cut into triangles, polygon i is pieces [pieceStarts[i], pieceStarts[i + 1]).
+    // Corners are stored one array per coordinate so tests run over many pieces at once
+    int* pieceStarts;     // count + 1
+    float* cornerX[3];
+    float* cornerY[3];
+    int pieceCount;
+    CollisionNode* nodes; // nodes[0] is the root, no nodes when nothing can collide
+    int nodeCount;
+    int* order;           // polygon indices grouped by leaf
+} CollisionShapes;
+
+// which cells of a map a solid polygon reaches, one bit per cell, rows of 64 bit words
+typedef struct {
+    float cellSize;       // world pixels per cell side
+    int x, y;             // cell coordinate of the first cell
+    int width, height;    // in cells, everything outside is empty
+    int rowWords;
+    uint64_t* solid;      // cells entirely inside a polygon
+    uint64_t* edge;       // cells a polygon edge passes through, these need the exact test
+} CollisionGrid;
+
+// the tile collision shapes of one resident chunk of an infinite map
+typedef struct ChunkCollision {
+    Arena* arena;         // owns everything below, goes when the chunk is evicted
+    CollisionShapes shapes;
+    CollisionGrid grid;
+    size_t bytes;         // counted in GameMap.chunkBytes
+} ChunkCollision;
+
+// everything needed to draw one tile id, filled once the textures are in
+typedef struct {
+    Texture2D texture;  // id 0 for ids no tileset covers
+    Rectangle source;   // cell in the tileset image
+} TileDraw;
+
+// a drawTable entry that changes over time, see AnimateMapTiles (map_render.h)
+typedef struct {
+    int tile;            // drawTable index it drives
+    int frameCount;
+    TileDraw* frames;    // what drawTable[tile] shows during each frame
+    int* frameEnds;      // ms into a cycle where each frame ends, the last one is the cycle
+    int current;         // frame in drawTable[tile] right now
+} AnimatedTile;
+
+// a tile object ("gid" object) from an object layer, a prop drawn over the
+// tile layers and depth sorted with the entities (map_objects.h)
+typedef struct {
+    float x, y;           // bottom-left corner in map pixels, where Tiled anchors it
+    float width, height;  // in map pixels, the tile is stretched to fit
+    TileId tile;          // drawTable index
+    unsigned char flip;   // TILE_FLIP_HORIZONTAL / TILE_FLIP_VERTICAL
+    unsigned char unused;
+} TileObject;
+
+// tile objects grouped by the square bucket their bottom-left corner is in
+typedef struct {
+    int bucketSize;        // side of a bucket in map pixels
+    int x, y;              // bucket coordinate of the first bucket
+    int width, height;     // in buckets
+    unsigned int* starts;  // width * height + 1, the objects of bucket b are [starts[b], starts[b + 1])
+    float reachX, reachY;  // largest object size, how far one sticks out of its bucket
+} TileObjectGrid;
 
 typedef struct {
     char* targetMap;// target map name without .tmj
@@ -64,11 +213,48 @@ typedef struct {
     CollisionLayer collisionLayer;  //from object layer"Collision"
     MapTransition* transitions;     //from object layer "MapTransition"
     int transitionCount;
+    CollisionShapes solidShapes;    //collisionLayer then the shapes of placed tiles, in world space
+    CollisionGrid collisionGrid;    //solidShapes rasterized
+    CollisionShapes triggerShapes;  //transition trigger areas in world space, same order
+    struct PlacedShapes* tileShapes; //per tile id, where its collision shapes come from (map_collision.c)
+    int tileShapeCount;
+    TileObject* tileObjects;        //from every other object layer, in bucket order
+    int tileObjectCount;
+    TileObjectGrid objectGrid;
+    TileDraw* drawTable; // indexed by tile id (gid - 1), built by LoadGameMapTextures
+    int drawTableSize;
+    AnimatedTile* animatedTiles;
+    int animatedTileCount;
+    int* tileAnimations; // per drawTable entry, its animatedTiles index or -1 (NULL when none animate)
+    Arena* arena;       // every allocation that lives as long as the map
+    struct MapBake* bake; // tile layers baked into render textures (map_render.h)
+    void* blob;         // mmapped .tmb when loaded compiled, tiles/points/strings point into it
+    size_t blobSize;
+    // infinite maps stream their chunks in around the camera (map_chunks.h)
+    int infinite;
+    const char* source; // mapped .tmj kept open while chunks still decode from it
+    size_t sourceSize;
+    size_t chunkBudget; // bytes of decoded chunks allowed to stay resident
+    size_t chunkBytes;  // bytes of decoded chunks resident right now
+    unsigned int chunkFrame;
+    TileChunk** residentChunks;
+    int residentCount;
+    int residentCapacity;
 } GameMap;
 
 // Loads a game map from "Tiled/Tiledmaps/somemap.tmj"
+// uses the compiled "somemap.tmb" next to it when it is up to date
 GameMap LoadGameMap(const char* mapFilePath);
 
+// Parses the .tmj and its tilesets without loading textures (map compiler)
+GameMap LoadGameMapData(const char* mapFilePath);
+
+// LoadGameMap minus the textures, safe off the main thread (map_loader.h)
+GameMap LoadGameMapWithoutTextures(const char* mapFilePath);
+
+// Loads the tileset textures of a map from LoadGameMapData and builds its drawTable
+void LoadGameMapTextures(GameMap* map);
+
 //free stuff
 void UnloadGameMap(GameMap* map);
 
@@ -0,0 +1,266 @@
+#include "tileset_registry.h"
+#include "asset_workers.h"
+#include "constants.h"
+#include "map_binary.h"
+#include "texture_atlas.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+typedef struct {
+    Tileset tileset;        // owns source, imagePath, texture and shapes
+    long long modTime;      // of the .tsj when it was loaded
+    int refCount;
+    int stale;              // .tsj changed, dropped by the next trim
+    unsigned int lastUsed;  // releaseClock when the last reference was dropped
+} SharedTileset;
+
+static SharedTileset* entries = NULL;
+static int entryCount = 0;
+static int entryCapacity = 0;
+static unsigned int releaseClock = 0;
+static TilesetRegistryStats stats = {0};
+// maps are parsed on the loader thread while the game thread releases them
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+
+void FreeTilesetData(Tileset* tileset) {
+    ReleaseTexture(tileset->texture);
+    DestroyArena(tileset->arena);
+    memset(tileset, 0, sizeof(Tileset));
+}
+
+static int FindEntry(const char* path) {
+    for (int i = 0; i < entryCount; i++) {
+        if (!entries[i].stale && strcmp(entries[i].tileset.source, path) == 0)
+            return i;
+    }
+    return -1;
+}
+
+static void RemoveEntry(int index) {
+    FreeTilesetData(&entries[index].tileset);
+    entries[index] = entries[--entryCount];
+}
+
+void TrimTilesetRegistry(void) {
+    pthread_mutex_lock(&registryLock);
+    for (int i = entryCount - 1; i >= 0; i--) {
+        if (entries[i].stale && entries[i].refCount == 0)
+            RemoveEntry(i);
+    }
+    for (;;) {
+        int unused = 0, oldest = -1;
+        for (int i = 0; i < entryCount; i++) {
+            if (entries[i].refCount > 0) continue;
+            unused++;
+            if (oldest < 0 || entries[i].lastUsed < entries[oldest].lastUsed)
+                oldest = i;
+        }
+        if (unused <= TILESET_CACHE_SIZE) break;
+        TraceLog(LOG_INFO, "Tileset registry: dropping %s", entries[oldest].tileset.source);
+        RemoveEntry(oldest);
+    }
+    pthread_mutex_unlock(&registryLock);
+}
+
+static Tileset MapCopy(const SharedTileset* entry, int firstgid) {
+    Tileset copy = entry->tileset;
+    copy.firstgid = firstgid;
+    return copy;
+}
+
+int AcquireSharedTileset(const char* path, int firstgid, Tileset* out) {
+    pthread_mutex_lock(&registryLock);
+    int i = FindEntry(path);
+    // edited in Tiled since it was loaded: maps still using it keep the old
+    // one, otherwise it is left for TrimTilesetRegistry and parsed again
+    if (i >= 0 && entries[i].modTime != GetSourceModTime(path)) {
+        if (entries[i].refCount > 0) {
+            TraceLog(LOG_WARNING, "Tileset %s changed while in use, reload the maps using it", path);
+        } else {
+            entries[i].stale = 1;
+            i = -1;
+        }
+    }
+    if (i >= 0) {
+        entries[i].refCount++;
+        stats.hits++;
+        *out = MapCopy(&entries[i], firstgid);
+    }
+    pthread_mutex_unlock(&registryLock);
+    return i >= 0;
+}
+
+Tileset ShareTileset(Tileset loaded, int firstgid) {
+    if (!loaded.source)
+        return loaded;
+    pthread_mutex_lock(&registryLock);
+    // another thread parsed the same file since AcquireSharedTileset missed
+    int i = FindEntry(loaded.source);
+    if (i >= 0 && entries[i].modTime == GetSourceModTime(loaded.source)) {
+        FreeTilesetData(&loaded);
+        entries[i].refCount++;
+        stats.hits++;
+        Tileset copy = MapCopy(&entries[i], firstgid);
+        pthread_mutex_unlock(&registryLock);
+        return copy;
+    }
+    if (entryCount >= entryCapacity) {
+        int capacity = entryCapacity ? entryCapacity * 2 : 8;
+        SharedTileset* grown = (SharedTileset*)realloc(entries, capacity * sizeof(SharedTileset));
+        if (!grown) {
+            pthread_mutex_unlock(&registryLock);
+            return loaded;
+        }
+        entries = grown;
+        entryCapacity = capacity;
+    }
+    SharedTileset* entry = &entries[entryCount++];
+    entry->tileset = loaded;
+    entry->tileset.firstgid = 0;
+    entry->modTime = GetSourceModTime(loaded.source);
+    entry->refCount = 1;
+    entry->stale = 0;
+    entry->lastUsed = releaseClock;
+    stats.parses++;
+    Tileset copy = MapCopy(entry, firstgid);
+    pthread_mutex_unlock(&registryLock);
+    return copy;
+}
+
+// matched by pointer: a stale entry may share the path with a newer one
+static SharedTileset* EntryOf(const Tileset* tileset) {
+    if (!tileset->source) return NULL;
+    for (int i = 0; i < entryCount; i++) {
+        if (entries[i].tileset.source == tileset->source)
+            return &entries[i];
+    }
+    return NULL;
+}
+
+void ReleaseSharedTileset(const Tileset* tileset) {
+    pthread_mutex_lock(&registryLock);
+    SharedTileset* entry = EntryOf(tileset);
+    if (entry && entry->refCount > 0 && --entry->refCount == 0)
+        entry->lastUsed = ++releaseClock;
+    pthread_mutex_unlock(&registryLock);
+}
+
+int TilesetNeedsTexture(const Tileset* tileset) {
+    pthread_mutex_lock(&registryLock);
+    SharedTileset* entry = EntryOf(tileset);
+    int needed = entry && entry->tileset.texture.id == 0 && entry->tileset.imagePath &&
+                 !FindAtlasImage(entry->tileset.imagePath);
+    pthread_mutex_unlock(&registryLock);
+    return needed;
+}
+
+void UploadSharedTilesetTexture(Tileset* tileset, Image image) {
+    pthread_mutex_lock(&registryLock);
+    SharedTileset* entry = EntryOf(tileset);
+    if (entry && entry->tileset.texture.id == 0 && image.data) {
+        entry->tileset.texture = LoadTextureFromImage(image);
+        stats.textureUploads++;
+    }
+    if (entry)
+        tileset->texture = entry->tileset.texture;
+    pthread_mutex_unlock(&registryLock);
+    UnloadImage(image);
+}
+
+Image* DecodeTilesetImages(const Tileset* tilesets, int count) {
+    Image* images = (Image*)calloc(count > 0 ? count : 1, sizeof(Image));
+    if (!images) return NULL;
+    AssetJob* job = BeginAssetJob();
+    for (int i = 0; i < count; i++) {
+        // imagePath is the shared one, it lives as long as the reference
+        if (TilesetNeedsTexture(&tilesets[i]))
+            QueueImageDecode(job, tilesets[i].imagePath, &images[i]);
+    }
+    FinishAssetJob(job);
+    return images;
+}
+
+void LoadSharedTilesetTexture(Tileset* tileset) {
+    pthread_mutex_lock(&registryLock);
+    SharedTileset* entry = EntryOf(tileset);
+    if (entry && entry->tileset.texture.id == 0 && entry->tileset.imagePath) {
+        const AtlasImage* atlas = FindAtlasImage(entry->tileset.imagePath);
+        if (atlas) {
+            // packed, BuildTileDrawTable finds the tiles on the page
+            entry->tileset.texture = atlas->texture;
+        } else {
+            entry->tileset.texture = LoadTexture(entry->tileset.imagePath);
+            stats.textureUploads++;
+        }
+    }
+    if (entry)
+        tileset->texture = entry->tileset.texture;
+    pthread_mutex_unlock(&registryLock);
+}
+
+const TileCollision* GetTileCollision(const Tileset* tileset, int tileId) {
+    int lo = 0, hi = tileset->shapeCount - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        TileShapes* shapes = &tileset->shapes[mid];
+        if (shapes->tileId < tileId) {
+            lo = mid + 1;
+            continue;
+        }
+        if (shapes->tileId > tileId) {
+            hi = mid - 1;
+            continue;
+        }
+        // tilesets are shared between maps and threads, the first caller expands
+        pthread_mutex_lock(&registryLock);
+        if (!shapes->expanded) {
+            // the polygons point into the packed points, nothing is copied
+            TileCollision* tc = (TileCollision*)ArenaAlloc(tileset->arena, sizeof(TileCollision));
+            Polygon* polygons = (Polygon*)ArenaAlloc(tileset->arena, shapes->polygonCount * sizeof(Polygon));
+            if (!tc || !polygons) {
+                pthread_mutex_unlock(&registryLock);
+                return NULL;
+            }
+            Vector2* points = shapes->points;
+            for (int i = 0; i < shapes->polygonCount; i++) {
+                polygons[i].points = points;
+                polygons[i].pointCount = shapes->pointCounts[i];
+                points += shapes->pointCounts[i];
+            }
+            tc->polygons = polygons;
+            tc->polygonCount = shapes->polygonCount;
+            shapes->expanded = tc;
+        }
+        const TileCollision* expanded = shapes->expanded;
+        pthread_mutex_unlock(&registryLock);
+        return expanded;
+    }
+    return NULL;
+}
+
+TilesetRegistryStats GetTilesetRegistryStats(void) {
+    pthread_mutex_lock(&registryLock);
+    TilesetRegistryStats s = stats;
+    s.resident = entryCount;
+    s.referenced = 0;
+    s.collisionTiles = s.collisionTilesUsed = 0;
+    for (int i = 0; i < entryCount; i++) {
+        s.referenced += entries[i].refCount > 0;
+        s.collisionTiles += entries[i].tileset.shapeCount;
+        for (int t = 0; t < entries[i].tileset.shapeCount; t++)
+            s.collisionTilesUsed += entries[i].tileset.shapes[t].expanded != NULL;
+    }
+    pthread_mutex_unlock(&registryLock);
+    return s;
+}
+
+void UnloadTilesetRegistry(void) {
+    pthread_mutex_lock(&registryLock);
+    for (int i = 0; i < entryCount; i++)
+        FreeTilesetData(&entries[i].tileset);
+    free(entries);
+    entries = NULL;
+    entryCount = entryCapacity = 0;
+    pthread_mutex_unlock(&registryLock);
+}
@@ -0,0 +1,75 @@
+#ifndef TILESET_REGISTRY_H
+#define TILESET_REGISTRY_H
+
+#include "tiled_loader.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tilesets (texture, image path, packed tile collision shapes) are shared by every
+// loaded GameMap through one registry keyed by the .tsj path. A map's Tileset
+// is a copy that points at the shared data, only firstgid is its own.
+// Unreferenced tilesets stay resident (up to TILESET_CACHE_SIZE of them) so
+// walking back into a map reuses them instead of parsing and uploading again.
+// Everything is safe to call from the map loader thread except the texture
+// upload functions and TrimTilesetRegistry, which need the GL thread.
+
+// Fills *out with the resident tileset for path and takes a reference.
+// Returns 0 when it is not resident (or its .tsj changed since it was loaded)
+int AcquireSharedTileset(const char* path, int firstgid, Tileset* out);
+
+// Hands a freshly loaded tileset (keyed by its source) to the registry and
+// returns the map's copy, already referenced once. When another thread
+// shared the same file first, loaded is freed and that one is used
+Tileset ShareTileset(Tileset loaded, int firstgid);
+
+// drops one reference taken by Acquire/ShareTileset
+void ReleaseSharedTileset(const Tileset* tileset);
+
+// Collision shapes of a tile (local id), NULL when it has none. Expands the
+// packed shapes on first use, under the registry lock
+const TileCollision* GetTileCollision(const Tileset* tileset, int tileId);
+
+// frees unreferenced tilesets beyond TILESET_CACHE_SIZE, textures included
+void TrimTilesetRegistry(void);
+
+// 1 when the shared tileset has an image to decode, one that is not in the
+// texture atlas and has no texture yet
+int TilesetNeedsTexture(const Tileset* tileset);
+
+// sets tileset->texture, the image is uploaded only the first time (atlas
+// tilesets get the atlas page)
+void LoadSharedTilesetTexture(Tileset* tileset);
+
+// same with an image decoded elsewhere (loader thread), image is freed
+void UploadSharedTilesetTexture(Tileset* tileset, Image image);
+
+// Decodes the images of the tilesets that still need a texture on the asset
+// workers (asset_workers.h). One Image per tileset, blank where nothing was
+// needed; free the array, the images go to UploadSharedTilesetTexture
+Image* DecodeTilesetImages(const Tileset* tilesets, int count);
+
+// unloads the texture and the tileset's arena (for tilesets outside the registry)
+void FreeTilesetData(Tileset* tileset);
+
+typedef struct {
+    int resident;         // tilesets in the registry
+    int referenced;       // of those, used by a loaded map
+    int parses;           // tilesets loaded from scratch
+    int hits;             // acquires served from the registry
+    int textureUploads;
+    int collisionTiles;   // tiles with collision shapes, resident tilesets
+    int collisionTilesUsed;   // of those, expanded by GetTileCollision
+} TilesetRegistryStats;
+
+TilesetRegistryStats GetTilesetRegistryStats(void);
+
+// frees everything, textures included (call before CloseWindow)
+void UnloadTilesetRegistry(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,77 @@
+#include "world_view.h"
+#include "constants.h"
+#include <math.h>
+
+void InitWorldView(WorldView* view, float scale, int integerScale) {
+    *view = (WorldView){ 0 };
+    view->scale = scale;
+    view->integerScale = integerScale;
+    view->shownScale = scale;
+}
+
+void FitWorldView(WorldView* view, Camera2D* camera) {
+    float scale = view->scale > 0.0f ? view->scale : PIXEL_SCALE;
+    if (view->integerScale)
+        scale = fmaxf(1.0f, floorf(scale + 0.5f));
+    view->shownScale = scale;
+    camera->zoom = scale / PIXEL_SCALE;
+
+    #if NATIVE_RESOLUTION_RENDER
+    // a spare texel each way for the snapped off part of the camera
+    int width = (int)ceilf(GetScreenWidth() / scale) + 1;
+    int height = (int)ceilf(GetScreenHeight() / scale) + 1;
+    if (view->target.id != 0 && width == view->width && height == view->height) return;
+    UnloadWorldView(view);
+    view->target = LoadRenderTexture(width, height);
+    if (view->target.id == 0) {
+        TraceLog(LOG_WARNING, "World view: no %dx%d render texture, drawing at window resolution", width, height);
+        return;
+    }
+    SetTextureFilter(view->target.texture, TEXTURE_FILTER_POINT);
+    view->width = width;
+    view->height = height;
+    #endif
+}
+
+void BeginWorldView(WorldView* view, Camera2D camera, Color background) {
+    if (view->target.id == 0) {
+        BeginMode2D(camera);
+        return;
+    }
+    // world position of the window's top left corner, snapped down to a texel
+    float texel = view->shownScale / camera.zoom;
+    float left = camera.target.x - camera.offset.x / camera.zoom;
+    float top = camera.target.y - camera.offset.y / camera.zoom;
+    float snappedLeft = floorf(left / texel) * texel;
+    float snappedTop = floorf(top / texel) * texel;
+
+    Camera2D native = { 0 };
+    native.target = (Vector2){ snappedLeft, snappedTop };
+    native.zoom = 1.0f / texel;
+    view->dest = (Rectangle){
+        -(left - snappedLeft) / texel * view->shownScale,
+        -(top - snappedTop) / texel * view->shownScale,
+        view->width * view->shownScale,
+        view->height * view->shownScale
+    };
+    BeginTextureMode(view->target);
+    ClearBackground(background);
+    BeginMode2D(native);
+}
+
+void EndWorldView(WorldView* view) {
+    EndMode2D();
+    if (view->target.id == 0) return;
+    EndTextureMode();
+    // render textures are stored upside down
+    Rectangle source = { 0.0f, 0.0f, (float)view->width, -(float)view->height };
+    DrawTexturePro(view->target.texture, source, view->dest, (Vector2){ 0.0f, 0.0f }, 0.0f, WHITE);
+}
+
+void UnloadWorldView(WorldView* view) {
+    if (view->target.id != 0)
+        UnloadRenderTexture(view->target);
+    view->target = (RenderTexture2D){ 0 };
+    view->width = 0;
+    view->height = 0;
+}
@@ -0,0 +1,46 @@
+#ifndef WORLD_VIEW_H
+#define WORLD_VIEW_H
+
+#include "raylib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The world is drawn at the art's own resolution into one render texture
+// and scaled up to the window in a single nearest-neighbour draw, instead of
+// every tile and sprite filling PIXEL_SCALE times more pixels. World
+// coordinates stay in PIXEL_SCALE units, the camera into the texture just
+// has zoom 1 / PIXEL_SCALE so one art pixel is one texel.
+// The camera snaps to whole art pixels inside the texture, the part left
+// over shifts the upscaled quad, so everything shares one pixel grid and
+// scrolling stays smooth. Camera rotation is not supported.
+
+typedef struct {
+    RenderTexture2D target;  // id 0 while drawing straight to the window
+    int width, height;       // of target, in art pixels
+    float scale;             // window pixels per art pixel, free to change between frames
+    int integerScale;        // round scale to a whole number so every art pixel is the same size
+    float shownScale;        // scale after rounding, set by FitWorldView
+    Rectangle dest;          // where target goes in the window, set by BeginWorldView
+} WorldView;
+
+// nothing is allocated until the first FitWorldView
+void InitWorldView(WorldView* view, float scale, int integerScale);
+
+// Resizes the target for the window and sets camera->zoom to what will be
+// shown, call before anything culls or streams with the camera
+void FitWorldView(WorldView* view, Camera2D* camera);
+
+// BeginMode2D into the target (cleared to background) and back out, EndWorldView
+// draws it to the window. Without a target these are BeginMode2D/EndMode2D
+void BeginWorldView(WorldView* view, Camera2D camera, Color background);
+void EndWorldView(WorldView* view);
+
+void UnloadWorldView(WorldView* view);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif